@@ -5,6 +5,22 @@
 #include <string.h>
 #include <time.h>
 #include <iso646.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <pthread.h>
+#include <limits.h>
+#include <strings.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include <sys/inotify.h>
+#include <poll.h>
+#if defined(__linux__) and __has_include(<linux/io_uring.h>) and defined(__NR_io_uring_setup) and defined(__NR_io_uring_register)
+	#define N2_HAVE_URING 1	// Raw system calls, no need for liburing
+	#include <linux/io_uring.h>
+	#include <linux/stat.h>	// struct statx without _GNU_SOURCE
+#endif
 //#include <threads.h>	// Only for thread_local variable definitions (C11). Better use __thread instead
 //#include <sys/stat.h>	// Only for stat.h in case FirstTimeStamp is missing
 
@@ -23,14 +39,137 @@
 
 // Forward declarations
 static const char* ConfigToDataName(const char* ConfigPathName);
+static void ClearConfig(tN2data *N2data, int KeepArena);
+static int AllocRows(tN2data *N2data, long long NbRows);
+static int ReadConfig(const char* ConfigPathName, const char* Text, tN2data *N2data, int Quick);
 static long long GetMissingFirstTimeStamp(const char* DataPathName);
 static long long GetMissingLastTimeStamp (const char* DataPathName, int NbCols);
-static int ReadData(const char* PathName, tN2data *N2data, long long AltFirstTimeStamp);
+static long long ReadData(const char* PathName, tN2data *N2data, long long AltFirstTimeStamp, 
+						  long long TimeStampLow, long long TimeStampHigh);
+static int GetRunParts(const char* RootDirName, int Direct, int RunNo, const char* Subsystem, int *Parts[]);
 
 
 #define NANO_TO_SEC(TimeStamp) ((TimeStamp)/1e9)
 #define ST "%Y%m%d-%H%M%S"
-int NbAlloc=0, NbFree=0;	// Debug
+#define N2_ALIGN 64		// Cache line size, for the columnar layout
+#define N2_BLOCK_SIZE (4*1024*1024)	// Size of the chunks read at once from data files
+#define FILE_NBCOL(N2data) ((N2data)->NbFileCol>0 ? (N2data)->NbFileCol : (N2data)->NbCol)	// Record width in the data file, minus the EOL
+int NbAlloc=0, NbFree=0;	// Debug. Atomic increments, files are read from several threads
+
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	Allocate a cache-line aligned block, rounded up to a multiple of N2_ALIGN. Free it with free()
+///////////////////////////////////////////////////////////////////////////////
+static void* AlignedAlloc(size_t Size) {
+	void *P=NULL;
+	Size=(Size+N2_ALIGN-1)/N2_ALIGN*N2_ALIGN;
+	if (posix_memalign(&P, N2_ALIGN, Size==0 ? N2_ALIGN : Size)) return NULL;
+	return P;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	There is no aligned realloc, so allocate+copy+free. Old is freed only on success
+///////////////////////////////////////////////////////////////////////////////
+static void* AlignedRealloc(void* Old, size_t OldSize, size_t NewSize) {
+	void *P=AlignedAlloc(NewSize);
+	if (P==NULL) return NULL;
+	if (Old) { memcpy(P, Old, OldSize<NewSize ? OldSize : NewSize); free(Old); }
+	return P;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Arena: when UseArena is set, the headers, strings and rows of a tN2data come from a few big chunks 
+// released at once. Only the growable arrays (TimeStamp, Data, Cols) stay on the heap
+///////////////////////////////////////////////////////////////////////////////
+
+#define N2_ARENA_CHUNK (64*1024)	// Enough for the header of most files
+
+struct sN2arena {
+	struct sN2arena *Next;
+	size_t Size, Used;
+	_Alignas(16) char Mem[];
+};
+
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	Bump allocation of zeroed memory, 16-byte aligned. Big requests get their own chunk
+///////////////////////////////////////////////////////////////////////////////
+static void* ArenaAlloc(struct sN2arena **Arena, size_t Size) {
+	Size=(Size+15)/16*16;
+	struct sN2arena *A=*Arena;
+	if (A!=NULL and A->Used+Size<=A->Size) {
+		void *P=A->Mem+A->Used;
+		A->Used+=Size;
+		return memset(P, 0, Size);
+	}
+	size_t ChunkSize=(Size>N2_ARENA_CHUNK/4 ? Size : N2_ARENA_CHUNK);
+	struct sN2arena *New=calloc(1, sizeof(struct sN2arena)+ChunkSize);
+	if (New==NULL) return NULL;
+	__sync_fetch_and_add(&NbAlloc, 1);
+	New->Size=ChunkSize;
+	New->Used=Size;
+	if (A!=NULL and ChunkSize==Size) { New->Next=A->Next; A->Next=New; }	// Keep filling the current one
+	else { New->Next=A; *Arena=New; }
+	return New->Mem;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	Release all chunks, or keep one regular chunk empty to be reused by the next file
+///////////////////////////////////////////////////////////////////////////////
+static void ArenaRelease(struct sN2arena **Arena, int KeepOne) {
+	struct sN2arena *Kept=NULL;
+	for (struct sN2arena *A=*Arena, *Next; A!=NULL; A=Next) {
+		Next=A->Next;
+		if (KeepOne and Kept==NULL and A->Size==N2_ARENA_CHUNK) { Kept=A; continue; }
+		free(A); __sync_fetch_and_add(&NbFree, 1);
+	}
+	if (Kept) { Kept->Next=NULL; Kept->Used=0; }
+	*Arena=Kept;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	Allocation of zeroed memory belonging to N2data: from its arena if it uses one, otherwise calloc
+///////////////////////////////////////////////////////////////////////////////
+static void* N2alloc(tN2data *N2data, size_t Size) {
+	return N2data->UseArena ? ArenaAlloc(&N2data->Arena, Size) : calloc(1, Size ? Size : 1);
+}
+
+static char* N2strdup(tN2data *N2data, const char* Str) {
+	if (!N2data->UseArena) return strdup(Str);
+	char *P=ArenaAlloc(&N2data->Arena, strlen(Str)+1);
+	return P ? strcpy(P, Str) : NULL;
+}
+
+static void N2free(tN2data *N2data, void *P) {
+	if (!N2data->UseArena and P!=NULL) free(P);	// Arena memory goes away with the arena
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	Make sure there is room for at least NewSize rows in TimeStamp[] and Data[] or Cols[][]
+/// HIRET	0 or -ENOMEM
+///////////////////////////////////////////////////////////////////////////////
+static int ReserveRows(tN2data *N2data, long long NewSize) {
+	if (NewSize<=N2data->ReservedSize) return 0;
+	if (N2data->Columnar) {
+		if (N2data->Cols==NULL and NULL==(N2data->Cols=calloc(N2data->NbCol, sizeof(void*)))) return -(errno=ENOMEM);
+		void *P=AlignedRealloc(N2data->TimeStamp, N2data->NbRow*sizeof(long long), NewSize*sizeof(long long));
+		if (P==NULL) return -(errno=ENOMEM);
+		N2data->TimeStamp=P;
+		for (int i=0; i<N2data->NbCol; i++) {
+			P=AlignedRealloc(N2data->Cols[i], N2data->NbRow*8, NewSize*8);
+			if (P==NULL) return -(errno=ENOMEM);
+			N2data->Cols[i]=P;
+		}
+	} else {
+		void *P=realloc(N2data->TimeStamp, NewSize*sizeof(long long));
+		if (P==NULL) return -(errno=ENOMEM);
+		N2data->TimeStamp=P;
+		P=realloc(N2data->Data, NewSize*sizeof(void*));
+		if (P==NULL) return -(errno=ENOMEM);
+		N2data->Data=P;
+		for (long long i=N2data->NbRow; i<NewSize; i++) N2data->Data[i]=NULL;
+	}
+	N2data->ReservedSize=NewSize;
+	return 0;
+}
 
 ///////////////////////////////////////////////////////////////////////////////
 /// HIFN	Equivalent to strftime()
@@ -67,14 +206,508 @@ void N2_NanoToDate(long long TimeStamp, int* Year, int* Month, int* Day, int* Ho
 	*Nano=(int)(TimeStamp%1000000000);
 }
 
+///////////////////////////////////////////////////////////////////////////////
+// Persistent cache of parsed headers, see N2_OpenHeaderCache().
+// The cache file is a magic string followed by tHdRec records, in native byte order.
+// A record is valid as long as the .hd keeps the same size and modification time.
+// The table is shared by all threads, behind a read/write lock
+///////////////////////////////////////////////////////////////////////////////
+
+#define HDCACHE_MAGIC "N2HDC001"
+
+typedef struct sHdRec {
+	unsigned int Len;			// Of the whole record including the strings, multiple of 8
+	int RunNo, CycNo, NbCol;
+	long long Size, MTime;		// Of the .hd file, MTime in ns
+	unsigned long long EOLidentifier;
+	long long FirstTimeStamp, LastTimeStamp, LastWrite;	// From the header with missing values as 0, before any guess from the data file
+	char Str[];					// Path, Name, then Name, Description and DataType of each column, all NUL terminated
+} tHdRec;
+
+static struct {
+	pthread_rwlock_t Lock;
+	char *PathName;				// NULL if there is no cache
+	char *File;					// Content of the cache file when loaded, the records point inside
+	long long FileSize;
+	tHdRec **Table;				// Open addressing, size power of 2
+	unsigned long long *Hashes;
+	int Size, Nb, Dirty;
+} HdCache={ .Lock=PTHREAD_RWLOCK_INITIALIZER };
+
+static unsigned long long HashStr(const char* Str) {	// FNV-1a
+	unsigned long long H=0xCBF29CE484222325ULL;
+	for (; *Str; Str++) H=(H^(unsigned char)*Str)*0x100000001B3ULL;
+	return H;
+}
+
+static void HdCacheFreeRec(tHdRec *Rec) {
+	if ((char*)Rec<HdCache.File or (char*)Rec>=HdCache.File+HdCache.FileSize) free(Rec);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	Add or replace a record in the table. Call with the write lock
+/// HIRET	-errno or 0
+///////////////////////////////////////////////////////////////////////////////
+static int HdCacheInsert(tHdRec *Rec) {
+	if (2*(HdCache.Nb+1)>HdCache.Size) {	// Grow and rehash
+		int NewSize=(HdCache.Size ? 2*HdCache.Size : 1024);
+		tHdRec **Table=calloc(NewSize, sizeof(tHdRec*));
+		unsigned long long *Hashes=calloc(NewSize, sizeof(unsigned long long));
+		if (Table==NULL or Hashes==NULL) { free(Table); free(Hashes); return -(errno=ENOMEM); }
+		for (int i=0; i<HdCache.Size; i++) 
+			if (HdCache.Table[i]) {
+				int j=HdCache.Hashes[i] & (NewSize-1);
+				while (Table[j]) j=(j+1) & (NewSize-1);
+				Table[j]=HdCache.Table[i]; Hashes[j]=HdCache.Hashes[i];
+			}
+		free(HdCache.Table); free(HdCache.Hashes);
+		HdCache.Table=Table; HdCache.Hashes=Hashes; HdCache.Size=NewSize;
+	}
+	unsigned long long H=HashStr(Rec->Str);
+	int j=H & (HdCache.Size-1);
+	for (; HdCache.Table[j]; j=(j+1) & (HdCache.Size-1))
+		if (HdCache.Hashes[j]==H and 0==strcmp(HdCache.Table[j]->Str, Rec->Str)) {
+			HdCacheFreeRec(HdCache.Table[j]);
+			HdCache.Table[j]=Rec;
+			return 0;
+		}
+	HdCache.Table[j]=Rec; HdCache.Hashes[j]=H;
+	HdCache.Nb++;
+	return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	Find a record, with the read or write lock
+///////////////////////////////////////////////////////////////////////////////
+static const tHdRec* HdCacheFind(const char* Path) {
+	if (HdCache.Size==0) return NULL;
+	unsigned long long H=HashStr(Path);
+	for (int j=H & (HdCache.Size-1); HdCache.Table[j]; j=(j+1) & (HdCache.Size-1))
+		if (HdCache.Hashes[j]==H and 0==strcmp(HdCache.Table[j]->Str, Path)) return HdCache.Table[j];
+	return NULL;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	Check that a record read from the file is complete
+///////////////////////////////////////////////////////////////////////////////
+static int HdRecValid(const tHdRec *Rec, long long Avail) {
+	if (Avail<(long long)sizeof(tHdRec) or Rec->Len<sizeof(tHdRec) or Rec->Len%8 or Rec->Len>Avail or Rec->NbCol<0) return 0;
+	const char *S=Rec->Str, *End=(const char*)Rec+Rec->Len;
+	for (int n=0; n<2+3*Rec->NbCol; n++) {	// All strings are there
+		S=memchr(S, '\0', End-S);
+		if (S==NULL) return 0;
+		S++;
+	}
+	return 1;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	Fill N2data from a valid cached record for this header
+/// HIPAR	St / Stat of the header, already done
+/// HIRET	1 if found and up to date, 0 if not, -errno
+///////////////////////////////////////////////////////////////////////////////
+static int SetColumn(tN2data *N2data, const char* Name, const char* Description, const char* DataType);
+
+static int HdCacheGet(const char* ConfigPathName, const struct stat *St, tN2data *N2data) {
+	int R=0;
+	pthread_rwlock_rdlock(&HdCache.Lock);
+	const tHdRec *Rec=HdCacheFind(ConfigPathName);
+	if (Rec==NULL or Rec->Size!=St->st_size or Rec->MTime!=St->st_mtim.tv_sec*1000000000LL+St->st_mtim.tv_nsec) goto End;
+	
+	const char *S=Rec->Str+strlen(Rec->Str)+1;
+	N2data->Name=N2strdup(N2data, S); S+=strlen(S)+1;
+	N2data->RunNo=Rec->RunNo; N2data->CycNo=Rec->CycNo;
+	N2data->EOLidentifier=Rec->EOLidentifier;
+	N2data->FirstTimeStamp=Rec->FirstTimeStamp; N2data->LastTimeStamp=Rec->LastTimeStamp; N2data->LastWrite=Rec->LastWrite;
+	N2data->Columns=N2alloc(N2data, Rec->NbCol*sizeof(tColumn));
+	N2data->Labels =N2alloc(N2data, Rec->NbCol*sizeof(char*));
+	if (N2data->Name==NULL or N2data->Columns==NULL or N2data->Labels==NULL) { R=-(errno=ENOMEM); goto End; }
+	for (int i=0; i<Rec->NbCol; i++) {
+		const char *Name=S, *Descr=Name+strlen(Name)+1, *Type=Descr+strlen(Descr)+1;
+		S=Type+strlen(Type)+1;
+		if ((R=SetColumn(N2data, Name, Descr, Type))<0) goto End;
+	}
+	R=1;
+End:
+	pthread_rwlock_unlock(&HdCache.Lock);
+	return R;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	Store the header just parsed in the cache
+/// HIFN	The timestamps are stored after the 1->0 conversion of missing values and before
+/// HIFN	GetMissingFirstTimeStamp() and co, HdCacheGet() resumes at the same point
+///////////////////////////////////////////////////////////////////////////////
+static void HdCachePut(const char* ConfigPathName, const struct stat *St, const tN2data *N2data) {
+	size_t Len=sizeof(tHdRec)+strlen(ConfigPathName)+1+strlen(N2data->Name)+1;
+	for (int i=0; i<N2data->NbCol; i++) 
+		Len+=strlen(N2data->Columns[i].Name)+strlen(N2data->Columns[i].Description)+strlen(N2data->Columns[i].DataType)+3;
+	Len=(Len+7)/8*8;
+	tHdRec *Rec=calloc(1, Len);
+	if (Rec==NULL) return;	// Not a problem
+	*Rec=(tHdRec){ .Len=Len, .RunNo=N2data->RunNo, .CycNo=N2data->CycNo, .NbCol=N2data->NbCol,
+				   .Size=St->st_size, .MTime=St->st_mtim.tv_sec*1000000000LL+St->st_mtim.tv_nsec,
+				   .EOLidentifier=N2data->EOLidentifier, .FirstTimeStamp=N2data->FirstTimeStamp, 
+				   .LastTimeStamp=N2data->LastTimeStamp, .LastWrite=N2data->LastWrite };
+	char *S=stpcpy(Rec->Str, ConfigPathName)+1;
+	S=stpcpy(S, N2data->Name)+1;
+	for (int i=0; i<N2data->NbCol; i++) {
+		S=stpcpy(S, N2data->Columns[i].Name)+1;
+		S=stpcpy(S, N2data->Columns[i].Description)+1;
+		S=stpcpy(S, N2data->Columns[i].DataType)+1;
+	}
+	pthread_rwlock_wrlock(&HdCache.Lock);
+	if (HdCache.PathName==NULL or HdCacheInsert(Rec)<0) free(Rec);	// Closed meanwhile
+	else HdCache.Dirty=1;
+	pthread_rwlock_unlock(&HdCache.Lock);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	Write the cache file if there are new records, through a temporary file
+/// HIRET	-errno or number of records
+///////////////////////////////////////////////////////////////////////////////
+static int HdCacheSave(void) {
+	if (HdCache.PathName==NULL) return -(errno=EBADF);
+	if (!HdCache.Dirty) return HdCache.Nb;
+	char Tmp[PATH_MAX];
+	snprintf(Tmp, sizeof(Tmp), "%s.%d.tmp", HdCache.PathName, (int)getpid());
+	FILE *F=fopen(Tmp, "wb");
+	if (F==NULL) { SLOG(SERR, "Cannot create %s: %s", Tmp, strerror(errno)); return -errno; }
+	int Ok=(1==fwrite(HDCACHE_MAGIC, 8, 1, F));
+	for (int i=0; Ok and i<HdCache.Size; i++)
+		if (HdCache.Table[i]) Ok=(1==fwrite(HdCache.Table[i], HdCache.Table[i]->Len, 1, F));
+	if (fclose(F) or !Ok or rename(Tmp, HdCache.PathName)) {
+		int R=-errno;
+		SLOG(SERR, "Cannot write %s: %s", HdCache.PathName, strerror(errno));
+		unlink(Tmp);
+		return R;
+	}
+	HdCache.Dirty=0;
+	SLOG(SNTC, "%d headers saved in %s", HdCache.Nb, HdCache.PathName);
+	return HdCache.Nb;
+}
+
+static void HdCacheClose(void) {
+	for (int i=0; i<HdCache.Size; i++) 
+		if (HdCache.Table[i]) HdCacheFreeRec(HdCache.Table[i]);
+	free(HdCache.Table); free(HdCache.Hashes); free(HdCache.File); free(HdCache.PathName);
+	HdCache.Table=NULL; HdCache.Hashes=NULL; HdCache.File=NULL; HdCache.PathName=NULL;
+	HdCache.FileSize=HdCache.Size=HdCache.Nb=HdCache.Dirty=0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	Use a persistent cache of parsed headers for all the following N2_ReadConfig()
+/// HIFN	Headers already in the cache and unchanged (same size and mtime) are not parsed again, only stat'ed.
+/// HIFN	New ones are added to the cache, written by N2_SaveHeaderCache() or N2_CloseHeaderCache()
+/// HIPAR	CachePathName / Cache file. It is created if it doesn't exist. Any previous cache is closed
+/// HIRET	-errno or number of headers in the cache
+///////////////////////////////////////////////////////////////////////////////
+int N2_OpenHeaderCache(const char* CachePathName) {
+	SLOG(SDBG, "Enter: %s", CachePathName);
+	N2_CloseHeaderCache();
+	pthread_rwlock_wrlock(&HdCache.Lock);
+	int R=0;
+	if (NULL==(HdCache.PathName=strdup(CachePathName))) { R=-(errno=ENOMEM); goto End; }
+	
+	int fd=open(CachePathName, O_RDONLY);
+	if (fd<0) { 
+		if (errno!=ENOENT) { R=-errno; SLOG(SERR, "Cannot open %s: %s", CachePathName, strerror(errno)); HdCacheClose(); }
+		goto End;	// Will be created
+	}
+	struct stat St;
+	if (fstat(fd, &St) or NULL==(HdCache.File=AlignedAlloc(St.st_size+1))) { 
+		R=(errno ? -errno : -(errno=ENOMEM)); close(fd); HdCacheClose(); goto End; }
+	long long Got=0;
+	for (ssize_t n; Got<St.st_size and (n=read(fd, HdCache.File+Got, St.st_size-Got))>0; Got+=n);
+	close(fd);
+	HdCache.FileSize=Got;
+	
+	if (Got<8 or memcmp(HdCache.File, HDCACHE_MAGIC, 8)) {
+		SLOG(SWRN, "%s is not a header cache, it will be rebuilt", CachePathName);
+		goto End;
+	}
+	for (long long Pos=8; Pos<Got; ) {
+		tHdRec *Rec=(tHdRec*)(HdCache.File+Pos);
+		if (!HdRecValid(Rec, Got-Pos)) { SLOG(SWRN, "Truncated header cache %s", CachePathName); HdCache.Dirty=1; break; }
+		if ((R=HdCacheInsert(Rec))<0) { HdCacheClose(); goto End; }
+		Pos+=Rec->Len;
+	}
+	SLOG(SNTC, "%d headers in %s", HdCache.Nb, CachePathName);
+	R=HdCache.Nb;
+End:
+	pthread_rwlock_unlock(&HdCache.Lock);
+	return R;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	Write the new headers to the cache file
+/// HIRET	-errno or number of headers in the cache
+///////////////////////////////////////////////////////////////////////////////
+int N2_SaveHeaderCache(void) {
+	pthread_rwlock_wrlock(&HdCache.Lock);
+	int R=HdCacheSave();
+	pthread_rwlock_unlock(&HdCache.Lock);
+	return R;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	Save and stop using the header cache
+///////////////////////////////////////////////////////////////////////////////
+void N2_CloseHeaderCache(void) {
+	pthread_rwlock_wrlock(&HdCache.Lock);
+	if (HdCache.PathName) HdCacheSave();
+	HdCacheClose();
+	pthread_rwlock_unlock(&HdCache.Lock);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Dedicated parser for the .hd files, which only use a small part of the libconfig syntax:
+// settings (name = value;) with strings, integers, floats, booleans and nested groups, and comments.
+// One pass over the text, strings unescaped in place, no allocation except the list of columns.
+// Anything else (lists, arrays, @include...) makes it give up, and ReadConfig() uses libconfig instead
+///////////////////////////////////////////////////////////////////////////////
+
+enum { HD_NONE, HD_STR, HD_INT, HD_FLOAT, HD_BOOL, HD_GROUP };
+
+typedef struct sHdValue {
+	int Type;
+	char *Str;					// HD_STR
+	long long Int;				// HD_INT
+} tHdValue;
+
+typedef struct sHdCol {
+	const char *Key; int KeyLen;	// column_000...
+	char *Name, *Description, *DataType;
+} tHdCol;
+
+typedef struct sHdParse {
+	tHdValue Name, EOLid, RunNo, CycNo, First, Last, LastWrite, Columns;
+	tHdCol *Cols;
+	int NbCols, SizeCols;
+} tHdParse;
+
+static void HdSkip(char **P) {	// Blanks and comments
+	for (char *C=*P;;) {
+		while (*C==' ' or *C=='\t' or *C=='\n' or *C=='\r' or *C=='\f' or *C=='\v') C++;
+		if (*C=='#' or (C[0]=='/' and C[1]=='/')) while (*C and *C!='\n') C++;
+		else if (C[0]=='/' and C[1]=='*') {
+			char *E=strstr(C+2, "*/");
+			C=(E ? E+2 : C+strlen(C));
+		} else { *P=C; return; }
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	Parse one value. Groups are parsed by HdParseGroup()
+/// HIRET	0 if not understood
+///////////////////////////////////////////////////////////////////////////////
+static int HdParseGroup(char **P, tHdParse *H, int Level, char End);
+
+static int HdParseValue(char **P, tHdValue *V, tHdParse *H, int Level) {
+	char *C=*P;
+	if (*C=='"') {	// Adjacent strings are concatenated, like in C
+		char *W=V->Str=C+1;
+		while (*C=='"') {
+			for (C++; *C!='"'; C++) {
+				if (*C=='\0') return 0;
+				if (*C!='\\') { *W++=*C; continue; }
+				switch (*++C) {
+					case '\\': case '"': *W++=*C; break;
+					case 'n': *W++='\n'; break;
+					case 't': *W++='\t'; break;
+					case 'r': *W++='\r'; break;
+					case 'f': *W++='\f'; break;
+					case 'x': {
+						int Hex=0;
+						for (int k=0; k<2; k++, C++) {
+							char X=C[1];
+							if      (X>='0' and X<='9') Hex=Hex*16+X-'0';
+							else if (X>='a' and X<='f') Hex=Hex*16+X-'a'+10;
+							else if (X>='A' and X<='F') Hex=Hex*16+X-'A'+10;
+							else return 0;
+						}
+						*W++=(char)Hex; break;
+					}
+					default: return 0;
+				}
+			}
+			C++;
+			HdSkip(&C);
+		}
+		*W='\0';	// At most on the last closing quote
+		V->Type=HD_STR;
+	} else if (*C=='{') {
+		C++;
+		if (!HdParseGroup(&C, H, Level+1, '}')) return 0;
+		C++;
+		V->Type=HD_GROUP;
+	} else if (*C=='-' or *C=='+' or (*C>='0' and *C<='9') or *C=='.') {
+		char *E;
+		errno=0;
+		V->Int=strtoll(C, &E, (C[0]=='0' and (C[1]=='x' or C[1]=='X')) ? 16 : 10);
+		if (*E=='.' or *E=='e' or *E=='E') { strtod(C, &E); V->Type=HD_FLOAT; }
+		else {
+			if (errno or E==C) return 0;
+			if (*E=='L') E+=(E[1]=='L' ? 2 : 1);
+			V->Type=HD_INT;
+		}
+		if (errno or E==C or (*E>='0' and *E<='9') or (*E>='a' and *E<='z') or (*E>='A' and *E<='Z') or *E=='_') return 0;
+		C=E;
+	} else if (0==strncasecmp(C, "true", 4) or 0==strncasecmp(C, "false", 5)) {
+		C+=(C[0]=='t' or C[0]=='T' ? 4 : 5);
+		V->Type=HD_BOOL;
+	} else return 0;	// List, array... let libconfig handle it
+	*P=C;
+	return 1;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	Parse the settings of a group up to End (0 for the whole file)
+/// HIPAR	Level / 0: top, 1: in "columns", 2: in a column, more: ignored
+/// HIRET	0 if not understood
+///////////////////////////////////////////////////////////////////////////////
+static int HdParseGroup(char **P, tHdParse *H, int Level, char End) {
+	char *C=*P;
+	int Col=-1;
+	if (Level==2) Col=H->NbCols-1;
+	for (HdSkip(&C); *C!=End; HdSkip(&C)) {
+		if (*C=='\0') return 0;
+		char *Key=C;
+		if (not ((*C>='a' and *C<='z') or (*C>='A' and *C<='Z') or *C=='*')) return 0;
+		while ((*C>='a' and *C<='z') or (*C>='A' and *C<='Z') or (*C>='0' and *C<='9') or *C=='_' or *C=='-' or *C=='*') C++;
+		int KeyLen=C-Key;
+		HdSkip(&C);
+		if (*C!='=' and *C!=':') return 0;
+		C++;
+		HdSkip(&C);
+		
+		tHdValue V={0}, *Dest=NULL;
+		#define KEY(Str) (KeyLen==sizeof(Str)-1 and 0==memcmp(Key, Str, KeyLen))
+		if (Level==0) {
+			Dest= KEY("name")           ? &H->Name  : KEY("EOLidentifier") ? &H->EOLid : 
+				  KEY("runNo")          ? &H->RunNo : KEY("cycNo")         ? &H->CycNo : 
+				  KEY("firstTimeStamp") ? &H->First : KEY("lastTimeStamp") ? &H->Last  : 
+				  KEY("lastWrite")      ? &H->LastWrite : KEY("columns")   ? &H->Columns : NULL;
+			if (Dest and Dest->Type!=HD_NONE) return 0;	// Duplicate, an error for libconfig
+		} else if (Level==1) {	// Every item of "columns" counts, even if it's not a proper column
+			if (H->NbCols==H->SizeCols) {
+				tHdCol *Cols=realloc(H->Cols, (H->SizeCols=2*H->SizeCols+64)*sizeof(tHdCol));
+				if (Cols==NULL) return 0;
+				H->Cols=Cols;
+			}
+			H->Cols[H->NbCols++]=(tHdCol){ .Key=Key, .KeyLen=KeyLen };
+		}
+		if (!HdParseValue(&C, Dest ? Dest : &V, H, (Level==0 and Dest!=&H->Columns) ? 3 : Level)) return 0;
+		if (Level==2 and V.Type==HD_STR) {
+			if      (KEY("columnName"))        H->Cols[Col].Name       =V.Str;
+			else if (KEY("columnDescription")) H->Cols[Col].Description=V.Str;
+			else if (KEY("columnDataType"))    H->Cols[Col].DataType   =V.Str;
+		}
+		#undef KEY
+		HdSkip(&C);
+		if (*C==';' or *C==',') C++;
+	}
+	*P=C;
+	return 1;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	Read a header with the dedicated parser, and fill N2data the same way as with libconfig
+/// HIPAR	Text / Content of the file, or NULL to read it
+/// HIRET	1 if done, 0 if libconfig is needed, -errno
+///////////////////////////////////////////////////////////////////////////////
+static int ParseHeader(const char* ConfigPathName, const char* Text, tN2data *N2data) {
+	char *Buf=NULL;
+	if (Text) Buf=strdup(Text);
+	else {
+		int fd=open(ConfigPathName, O_RDONLY);
+		if (fd<0) return -errno;
+		struct stat St;
+		if (fstat(fd, &St)==0 and St.st_size<(1<<26) and NULL!=(Buf=malloc(St.st_size+1))) {
+			ssize_t n, Got=0;
+			while (Got<St.st_size and (n=read(fd, Buf+Got, St.st_size-Got))>0) Got+=n;
+			Buf[Got]='\0';
+		}
+		close(fd);
+	}
+	if (Buf==NULL) return 0;	// Let libconfig try
+	
+	tHdParse H={0};
+	char *C=Buf;
+	int R=HdParseGroup(&C, &H, 0, '\0');
+	if ((H.First.Type and H.First.Type!=HD_INT) or (H.Last.Type and H.Last.Type!=HD_INT) or 
+		(H.LastWrite.Type and H.LastWrite.Type!=HD_INT) or (H.RunNo.Type and H.RunNo.Type!=HD_INT) or 
+		(H.CycNo.Type and H.CycNo.Type!=HD_INT)) R=0;	// Leave the conversions to libconfig
+	if (R==0) { SLOG(SNTC, "Using libconfig for %s", ConfigPathName); goto End; }
+	
+	if (H.Name.Type==HD_STR) {
+		N2data->Name=N2strdup(N2data, H.Name.Str);
+		SLOG(SNTC, "Store name:\t%s", N2data->Name);
+	} else {
+		N2data->Name=N2strdup(N2data, "-Missing-");
+		SLOG(SERR, "No 'name' setting in configuration file.");
+	}
+	if (N2data->Name==NULL) { SLOG(SERR, "Out of memory"); R=-(errno=ENOMEM); goto End; }
+
+	if (H.EOLid.Type==HD_STR) N2data->EOLidentifier=strtoul(H.EOLid.Str, NULL, 0);
+	SLOG(SNTC, "EOLidentifier:\t0x%llX", N2data->EOLidentifier);
+	if (H.RunNo.Type and H.RunNo.Int>=INT_MIN and H.RunNo.Int<=INT_MAX) N2data->RunNo=H.RunNo.Int;
+	SLOG(SNTC, "RunNo:\t%d", N2data->RunNo);
+	if (H.CycNo.Type and H.CycNo.Int>=INT_MIN and H.CycNo.Int<=INT_MAX) N2data->CycNo=H.CycNo.Int;
+	SLOG(SNTC, "CycNo:\t%d", N2data->CycNo);
+
+	N2data->FirstTimeStamp=(H.First.Type ? H.First.Int : 1);
+	N2data->LastTimeStamp =(H.Last.Type  ? H.Last.Int  : 1);
+	if (!H.First.Type) SLOG(SWRN, "Missing firstTimeStamp");
+	if (!H.Last.Type)  SLOG(SNTC, "Missing lastTimeStamp");
+	if (H.LastWrite.Type) {
+		N2data->LastWrite=H.LastWrite.Int;
+		SLOG(SNTC, "LastWrite:\t%.3fs / %s", NANO_TO_SEC(N2data->LastWrite), N2_NanoToDateStr(N2data->LastWrite, ""));
+	}
+	
+	int Count=(H.Columns.Type==HD_GROUP ? H.NbCols : 0);
+	SLOG(SNTC, "Columns:\t%d", Count);
+	N2data->Columns=N2alloc(N2data, Count*sizeof(tColumn));
+	N2data->Labels =N2alloc(N2data, Count*sizeof(char*));
+	if (N2data->Columns==NULL or N2data->Labels==NULL) { SLOG(SERR, "Out of mem"); R=-(errno=ENOMEM); goto End; }
+	
+	while (N2data->NbCol<Count) {	// Looked up by name like with libconfig, normally in order
+		char Key[32];
+		int KeyLen=sprintf(Key, "column_%03d", N2data->NbCol), i=N2data->NbCol;
+		if (H.Cols[i].KeyLen!=KeyLen or memcmp(H.Cols[i].Key, Key, KeyLen))
+			for (i=0; i<Count and (H.Cols[i].KeyLen!=KeyLen or memcmp(H.Cols[i].Key, Key, KeyLen)); i++);
+		if (i==Count or !H.Cols[i].Name or !H.Cols[i].Description or !H.Cols[i].DataType) {
+			SLOG(SWRN, "Config column read failure: %s", Key); 
+			break; 
+		}
+		if (SetColumn(N2data, H.Cols[i].Name, H.Cols[i].Description, H.Cols[i].DataType)<0) { R=-errno; goto End; }
+	}
+	R=1;
+	
+End:
+	free(H.Cols);
+	free(Buf);
+	return R;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 /// HIFN	Read a configuration file and fill in the N2data structure
 /// HIPAR	ConfigPathName / To a .hd file
 /// HIPAR	Quick / 1: does not open the data file at all. 0: open it to guess missing NbRows
+/// HIPAR	Quick / 2: only the header, missing firstTimeStamp and lastTimeStamp stay 0. For a data file not written yet
 /// HIRET	-errno or number of columns (including TimeStamp)
+/// HIFN	See N2_OpenHeaderCache() to avoid parsing the same headers again and again
 ///////////////////////////////////////////////////////////////////////////////
 int N2_ReadConfig(const char* ConfigPathName, tN2data *N2data, int Quick) {
-	N2_ClearConfig(N2data);
+	return ReadConfig(ConfigPathName, NULL, N2data, Quick);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	Same as N2_ReadConfig()
+/// HIPAR	Text / Content of the configuration file if already read, or NULL to read it from ConfigPathName
+///////////////////////////////////////////////////////////////////////////////
+static int ReadConfig(const char* ConfigPathName, const char* Text, tN2data *N2data, int Quick) {
+	ClearConfig(N2data, 1);	// Reuse the arena, if any
 
 	config_t Config;
 	SLOG(SDBG, "Enter: %s", ConfigPathName);
@@ -83,25 +716,41 @@ int N2_ReadConfig(const char* ConfigPathName, tN2data *N2data, int Quick) {
 	if (P==NULL) return -(errno=ENOENT);	// Invalid filename
 	N2data->HdrVer=atoi(P+1);
 
-	N2data->ConfigPathname=strdup(ConfigPathName);
+	N2data->ConfigPathname=N2strdup(N2data, ConfigPathName);
 	if (N2data->ConfigPathname==NULL) return -(errno=ENOMEM);
 
+	struct stat St;
+	int UseCache=(Text==NULL and HdCache.PathName!=NULL and 0==stat(ConfigPathName, &St));	// Racy test, but the cache functions lock
+	if (UseCache) {
+		int R=HdCacheGet(ConfigPathName, &St, N2data);
+		if (R<0) return R;
+		if (R>0) { SLOG(SNTC, "From cache: %s", ConfigPathName); goto Parsed; }
+	}
+
+	int R=ParseHeader(ConfigPathName, Text, N2data);	// Faster than libconfig
+	if (R<0) { 
+		SLOG(SDBG, "%s when reading config file %s", strerror(-R), ConfigPathName); 
+		N2free(N2data, N2data->ConfigPathname); N2data->ConfigPathname=NULL; 
+		return R; 
+	}
+	if (R>0) goto Converted;
+
 	errno=0;
 	config_init (&Config);
-	if (!config_read_file (&Config, ConfigPathName)) {
+	if (!(Text ? config_read_string(&Config, Text) : config_read_file(&Config, ConfigPathName))) {
 		SLOG(SDBG, "%s line %d when reading config file %s", // This will happen when searching for possible successive files
 			 config_error_text(&Config), config_error_line(&Config), ConfigPathName);
 		config_destroy(&Config);
-		free(N2data->ConfigPathname); N2data->ConfigPathname=NULL; 
+		N2free(N2data, N2data->ConfigPathname); N2data->ConfigPathname=NULL; 
 		return errno ? -errno : -ENOENT;
 	}
 
 	const char *tmp=NULL;
 	if (config_lookup_string(&Config, "name", &tmp)) {
-		N2data->Name=strdup(tmp);
+		N2data->Name=N2strdup(N2data, tmp);
 		SLOG(SNTC, "Store name:\t%s", N2data->Name);
 	} else {
-		N2data->Name=malloc(10); strcpy(N2data->Name, "-Missing-");
+		N2data->Name=N2strdup(N2data, "-Missing-");
 		SLOG(SERR, "No 'name' setting in configuration file.");
 	}
 	if (N2data->Name==NULL) { SLOG(SERR, "Out of memory"); return -(errno=ENOMEM); }
@@ -134,8 +783,8 @@ int N2_ReadConfig(const char* ConfigPathName, tN2data *N2data, int Quick) {
 	if (setting != NULL) Count = config_setting_length(setting);
 	SLOG(SNTC, "Columns:\t%d", Count);
 
-	N2data->Columns=calloc(Count, sizeof(tColumn));
-	N2data->Labels =calloc(Count, sizeof(char*));
+	N2data->Columns=N2alloc(N2data, Count*sizeof(tColumn));
+	N2data->Labels =N2alloc(N2data, Count*sizeof(char*));
 	if (N2data->Columns==NULL or N2data->Labels==NULL) { SLOG(SERR, "Out of mem"); return -(errno=ENOMEM); }
 
 
@@ -152,36 +801,23 @@ int N2_ReadConfig(const char* ConfigPathName, tN2data *N2data, int Quick) {
 				break; 
 		}
 
-		N2data->Columns[N2data->NbCol].Name       =strdup(tmp1);	// We need to do this because config_destroy will remove the references
-		N2data->Columns[N2data->NbCol].Description=strdup(tmp2);
-		N2data->Columns[N2data->NbCol].DataType   =strdup(tmp3);
-		N2data->Labels [N2data->NbCol]=malloc(strlen(N2data->Columns[N2data->NbCol].Name) + 
-		                                      strlen(N2data->Columns[N2data->NbCol].Description) + 4);
-		if (NULL==N2data->Columns[N2data->NbCol].Name        or
-			NULL==N2data->Columns[N2data->NbCol].Description or
-			NULL==N2data->Columns[N2data->NbCol].DataType    or
-			NULL==N2data->Labels [N2data->NbCol]) { SLOG(SERR, "Out of mem"); return -(errno=ENOMEM); }
-
-		if (N2data->Columns[N2data->NbCol].Description[0]=='\0')
-			strcpy(  N2data->Labels [N2data->NbCol], N2data->Columns[N2data->NbCol].Name);
-		else sprintf(N2data->Labels [N2data->NbCol], "%s (%s)", 
-				N2data->Columns[N2data->NbCol].Name, N2data->Columns[N2data->NbCol].Description);
-
-		SLOG(SNTC, "Col %d:\t%s\t%s\t%s", N2data->NbCol, 
-				N2data->Columns[N2data->NbCol].Name, 
-				N2data->Columns[N2data->NbCol].Description, 
-				N2data->Columns[N2data->NbCol].DataType);	// NOTE: can be double or uint64, but all 8 bytes. Others maybe ???
-		N2data->NbCol++;
+		if (SetColumn(N2data, tmp1, tmp2, tmp3)<0) { config_destroy(&Config); return -errno; }
 	}
 
 	config_destroy (&Config); 	// this destroys the allocations, in particular the config_lookup_string
 
+Converted:
 	// Suboptimal, but better than nothing
 	if (N2data->FirstTimeStamp==1) N2data->FirstTimeStamp=0;	// Don't remember why I had to do this
 	if (N2data->LastTimeStamp ==1) N2data->LastTimeStamp=0;
+	if (UseCache) HdCachePut(ConfigPathName, &St, N2data);
+
+Parsed:
+	N2data->NbFileCol=N2data->NbCol;
+	if (Quick==2) { errno=0; return N2data->NbCol; }
 
 	const char* DataPath=ConfigToDataName(ConfigPathName);
-/**/if (!Quick) { N2data->NbRow=-1; ReadData(DataPath, N2data, 0); }
+/**/if (!Quick) { N2data->NbRow=-1; ReadData(DataPath, N2data, 0, 0, 0); }
 	if (N2data->FirstTimeStamp==0) 
 		N2data->FirstTimeStamp = GetMissingFirstTimeStamp(DataPath);
 	if (N2data->LastTimeStamp==0) 
@@ -208,41 +844,82 @@ int N2_ReadConfig(const char* ConfigPathName, tN2data *N2data, int Quick) {
 	return N2data->NbCol;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	Append a column to the header, copying the strings
+/// HIRET	-errno or 0
+///////////////////////////////////////////////////////////////////////////////
+static int SetColumn(tN2data *N2data, const char* Name, const char* Description, const char* DataType) {
+	tColumn *Col=&N2data->Columns[N2data->NbCol];
+	Col->Name       =N2strdup(N2data, Name);	// We need to do this because config_destroy will remove the references
+	Col->Description=N2strdup(N2data, Description);
+	Col->DataType   =N2strdup(N2data, DataType);
+	N2data->Labels [N2data->NbCol]=N2alloc(N2data, strlen(Name) + strlen(Description) + 4);
+	if (NULL==Col->Name or NULL==Col->Description or NULL==Col->DataType or NULL==N2data->Labels[N2data->NbCol]) { 
+		SLOG(SERR, "Out of mem"); return -(errno=ENOMEM); }
+
+	if (Description[0]=='\0')
+		strcpy(  N2data->Labels [N2data->NbCol], Name);
+	else sprintf(N2data->Labels [N2data->NbCol], "%s (%s)", Name, Description);
+
+	SLOG(SNTC, "Col %d:\t%s\t%s\t%s", N2data->NbCol, Name, Description, DataType);	// NOTE: can be double or uint64, but all 8 bytes. Others maybe ???
+	N2data->NbCol++;
+	return 0;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 /// HIFN	Free the data present in a tN2data structure and zero all parameters
+/// HIPAR	KeepArena / 1 to keep an empty arena chunk for the next file
 ///////////////////////////////////////////////////////////////////////////////
-void N2_ClearConfig(tN2data *N2data) {
+static void ClearConfig(tN2data *N2data, int KeepArena) {
 	SLOG(SDBG, "Enter. Currently %sNULL", N2data?"NOT ":"");
 	if (N2data==NULL) return;
-	if (N2data->Name          ) free(N2data->Name          );; N2data->Name          =NULL;
-	if (N2data->ConfigPathname) free(N2data->ConfigPathname);; N2data->ConfigPathname=NULL;
-	if (N2data->DataPathname  ) free(N2data->DataPathname  );; N2data->DataPathname  =NULL;
+	if (!N2data->UseArena) {	// Otherwise all this goes away at once with the arena
+		if (N2data->Name          ) free(N2data->Name          );; N2data->Name          =NULL;
+		if (N2data->ConfigPathname) free(N2data->ConfigPathname);; N2data->ConfigPathname=NULL;
+		if (N2data->DataPathname  ) free(N2data->DataPathname  );; N2data->DataPathname  =NULL;
 
-	if (N2data->Labels) {
-		for (int i=0; i<N2data->NbCol; i++)
-			if (N2data->Labels[i]) free(N2data->Labels[i]);
-		free(   N2data->Labels   );     N2data->Labels=NULL;
-	}
-	if (N2data->Columns) {
-		for (int i=0; i<N2data->NbCol; i++) {
-			if (N2data->Columns[i].Name       ) free(N2data->Columns[i].Name);
-			if (N2data->Columns[i].Description) free(N2data->Columns[i].Description);
-			if (N2data->Columns[i].DataType   ) free(N2data->Columns[i].DataType);
+		if (N2data->Labels) {
+			for (int i=0; i<N2data->NbCol; i++)
+				if (N2data->Labels[i]) free(N2data->Labels[i]);
+			free(   N2data->Labels   );     N2data->Labels=NULL;
+		}
+		if (N2data->Columns) {
+			for (int i=0; i<N2data->NbCol; i++) {
+				if (N2data->Columns[i].Name       ) free(N2data->Columns[i].Name);
+				if (N2data->Columns[i].Description) free(N2data->Columns[i].Description);
+				if (N2data->Columns[i].DataType   ) free(N2data->Columns[i].DataType);
+			}
+			free(   N2data->Columns               );     N2data->Columns  =NULL;
 		}
-		free(   N2data->Columns               );     N2data->Columns  =NULL;
+		if (N2data->Data) 
+			for (long long i=0; i<N2data->NbRow/*ReservedSize*/; i++) 
+				if (N2data->Data[i]) { free(N2data->Data[i]); __sync_fetch_and_add(&NbFree, 1); }
+		if (N2data->FileCol  ) free(N2data->FileCol);; N2data->FileCol=NULL;
 	}
 	if (N2data->TimeStamp) free(N2data->TimeStamp);; N2data->TimeStamp=NULL;
-	if (N2data->Data     ) {
-		for (int i=0; i<N2data->NbRow/*ReservedSize*/; i++) 
-			if (N2data->Data[i]) { free(N2data->Data[i]); NbFree++; }
-		free(   N2data->Data   );       N2data->Data=NULL;
+	if (N2data->Data     ) free(N2data->Data     );; N2data->Data=NULL;
+	if (N2data->Cols     ) {
+		for (int i=0; i<N2data->NbCol; i++) 
+			if (N2data->Cols[i]) free(N2data->Cols[i]);
+		free(   N2data->Cols   );       N2data->Cols=NULL;
 	}
+	ArenaRelease(&N2data->Arena, KeepArena);
+	struct sN2arena *Arena=N2data->Arena;
+	int Columnar=N2data->Columnar, NbThreads=N2data->NbThreads, UseArena=N2data->UseArena;	// Those are reading options, not data
 	N2data->FirstTimeStamp = N2data->LastTimeStamp = 
 	N2data->EOLidentifier  = N2data->RunNo = N2data->CycNo = 
 	N2data->HdrVer = N2data->NbCol = N2data->NbRow = N2data->ReservedSize = 0;
 	N2data->tFilter.StartTimeStamp=N2data->tFilter.Decimation=
 	N2data->tFilter.EndTimeStamp=  N2data->tFilter.MaxRows   =0;
 	bzero(N2data, sizeof(tN2data));	// Redundant, Just make sure everything is at 0
+	N2data->Columnar=Columnar;
+	N2data->NbThreads=NbThreads;
+	N2data->UseArena=UseArena;
+	N2data->Arena=Arena;
+}
+
+void N2_ClearConfig(tN2data *N2data) {
+	ClearConfig(N2data, 0);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -251,9 +928,11 @@ void N2_ClearConfig(tN2data *N2data) {
 ///////////////////////////////////////////////////////////////////////////////
 extern void N2_CopyConfig(tN2data *N2dest, const tN2data *N2source) {
 	if (N2dest==NULL or N2source==NULL) return;
-	N2dest->Name          =strdup(N2source->Name);
-	N2dest->ConfigPathname=strdup(N2source->ConfigPathname);
-	N2dest->DataPathname  =strdup(N2source->DataPathname);
+	N2dest->UseArena=N2source->UseArena;	// Same allocation scheme, but its own arena
+	N2dest->Arena=NULL;
+	N2dest->Name          =N2strdup(N2dest, N2source->Name);
+	N2dest->ConfigPathname=N2strdup(N2dest, N2source->ConfigPathname);
+	N2dest->DataPathname  =N2strdup(N2dest, N2source->DataPathname);
 	if (N2dest->Name==NULL or N2dest->ConfigPathname==NULL or N2dest->DataPathname==NULL) SLOG(SERR, "Out of memory");
 	
 	N2dest->EOLidentifier=N2source->EOLidentifier;
@@ -261,20 +940,24 @@ extern void N2_CopyConfig(tN2data *N2dest, const tN2data *N2source) {
 	N2dest->CycNo =N2source->CycNo;
 	N2dest->HdrVer=N2source->HdrVer;
 	N2dest->NbCol =N2source->NbCol;
+	N2dest->NbFileCol=N2source->NbFileCol;
+	N2dest->FileCol=NULL;
+	if (N2source->FileCol!=NULL and NULL!=(N2dest->FileCol=N2alloc(N2dest, N2dest->NbCol*sizeof(int))))
+		memcpy(N2dest->FileCol, N2source->FileCol, N2dest->NbCol*sizeof(int));
 	
 	if (N2source->Labels!=NULL) {
-		N2dest->Labels=calloc(N2dest->NbCol, sizeof(char*));
+		N2dest->Labels=N2alloc(N2dest, N2dest->NbCol*sizeof(char*));
 		for (int i=0; i<N2dest->NbCol; i++)
-			N2dest->Labels[i] = (N2source->Labels[i]==NULL ? NULL : strdup(N2source->Labels[i]));	// See https://stackoverflow.com/questions/6432384/strdup-dumping-core-on-passing-null
+			N2dest->Labels[i] = (N2source->Labels[i]==NULL ? NULL : N2strdup(N2dest, N2source->Labels[i]));	// See https://stackoverflow.com/questions/6432384/strdup-dumping-core-on-passing-null
 	} else N2dest=NULL;
 	
 	if (N2source->Columns!=NULL) {
 		if (N2dest->NbCol<=0) SLOG(SERR, "NbCols=%d", N2dest->NbCol);
-		N2dest->Columns=calloc(N2dest->NbCol, sizeof(tColumn));
+		N2dest->Columns=N2alloc(N2dest, N2dest->NbCol*sizeof(tColumn));
 		for (int i=0; i<N2dest->NbCol; i++) {
-			N2dest->Columns[i].Name       = (N2source->Columns[i].Name       ==NULL ? NULL : strdup(N2source->Columns[i].Name));
-			N2dest->Columns[i].Description= (N2source->Columns[i].Description==NULL ? NULL : strdup(N2source->Columns[i].Description));
-			N2dest->Columns[i].DataType   = (N2source->Columns[i].DataType   ==NULL ? NULL : strdup(N2source->Columns[i].DataType));
+			N2dest->Columns[i].Name       = (N2source->Columns[i].Name       ==NULL ? NULL : N2strdup(N2dest, N2source->Columns[i].Name));
+			N2dest->Columns[i].Description= (N2source->Columns[i].Description==NULL ? NULL : N2strdup(N2dest, N2source->Columns[i].Description));
+			N2dest->Columns[i].DataType   = (N2source->Columns[i].DataType   ==NULL ? NULL : N2strdup(N2dest, N2source->Columns[i].DataType));
 		}
 	} else N2dest->Columns=NULL;
 	
@@ -285,175 +968,849 @@ extern void N2_CopyConfig(tN2data *N2dest, const tN2data *N2source) {
 	N2dest->NbRow=N2dest->ReservedSize=0;	// Not copying data yet, this will be done by N2_AddDataWithFilter()
 	N2dest->TimeStamp=NULL;
 	N2dest->Data=NULL;
+	N2dest->Columnar=N2source->Columnar;	// Same layout. Set it after this call to convert during N2_AddDataWithFilter()
+	N2dest->Cols=NULL;
+	N2dest->NbThreads=N2source->NbThreads;
 
 	N2dest->tFilter=N2source->tFilter;
 }
 
 
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	Binary search in a sorted array of timestamps
+/// HIRET	Index of the first element >=TimeStamp (Nb if none)
+///////////////////////////////////////////////////////////////////////////////
+static long long LowerBound(const long long *TimeStamps, long long Nb, long long TimeStamp) {
+	long long Lo=0, Hi=Nb;
+	while (Lo<Hi) {
+		long long Mid=Lo+(Hi-Lo)/2;
+		if (TimeStamps[Mid]<TimeStamp) Lo=Mid+1; else Hi=Mid;
+	}
+	return Lo;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	Make sure there is room for NbRows rows in N2data, to fill it with N2_AddDataWithFilter()
+/// HIFN	Use it when the final size is known, to avoid any reallocation
+/// HIRET	-errno or 0
+///////////////////////////////////////////////////////////////////////////////
+int N2_ReserveRows(tN2data *N2data, long long NbRows) {
+	return ReserveRows(N2data, NbRows);
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 /// HIFN	Copy the copy the timestamp+data by applying the filter parameters
+/// HIFN	The time window is found by binary search and the rows are written straight to the destination,
+/// HIFN	so the cost is in the number of rows kept. The destination grows geometrically, see also N2_ReserveRows()
 /// HIPAR	Remaining / When using decimation on multiple files, 
 /// HIPAR	Remaining / number of points remaining since last decimation of previous file (0 on start)
 /// HIPAR	Remaining / This avoids the problem of files having less points than the decimation
-/// HIRET	Number of effectively added rows (or -errno)
+/// HIRET	Number of effectively added rows (or -errno). -EINVAL if the numbers of columns differ
 ///////////////////////////////////////////////////////////////////////////////
-int N2_AddDataWithFilter(tN2data *N2dest, tN2data *N2source, int* Remaining, 
-				int Decimation, int MaxRows, 
+long long N2_AddDataWithFilter(tN2data *N2dest, tN2data *N2source, int* Remaining, 
+				int Decimation, long long MaxRows, 
 				long long TimeStampLow, long long TimeStampHigh) {
-	if (Decimation==0) Decimation=1;
-	int R=0, CopiedRows=0, AddedRows=0,
-		MaxES=N2source->NbRow/Decimation; // Max Expected Size
-	
-	if (N2source->NbRow==0) return 0;
-	if (N2source->NbRow>0 and MaxES==0) MaxES=1;	// TODO: This should be rather fixed by using an offset
-	if (MaxES==0 or (MaxRows>0 and N2dest->NbRow>=MaxRows)) return 0;	// No data or already over
-	
-	unsigned long long* TempTimeStamp=calloc(MaxES, sizeof(unsigned long long));
-	void**              TempData     =calloc(MaxES, 8);	// double or uint64
-	if (TempTimeStamp==NULL or TempData==NULL) { R=-ENOMEM; goto End; }
-
-	int SourceR=(Decimation-*Remaining)%Decimation;	// Skip the 1st points
-	for (int NbR=0; NbR<MaxES; NbR++, SourceR+=Decimation)
-		if (SourceR<N2source->NbRow and
-			(TimeStampLow ==0 or TimeStampLow<=N2source->TimeStamp[SourceR]               ) and 
-			(TimeStampHigh==0 or               N2source->TimeStamp[SourceR]<=TimeStampHigh)) {
-			TempTimeStamp[CopiedRows] =  N2source->TimeStamp[SourceR];
-			TempData     [CopiedRows] =  N2source->Data     [SourceR];	// Point to same thing
-			N2source->Data[SourceR] = NULL;	// So that ClearConfig won't the transfered destination
-//			memcpy(TempData[CopiedRows], N2source->Data     [SourceR], N2source->NbCol*sizeof(double));
-			CopiedRows++;
-		}
-	*Remaining=(N2source->NbRow /*-Decimation*/ + *Remaining)%Decimation;	// Number of remaining points before next decimation
-	
-	if (CopiedRows>0) {
-		if (N2dest->ReservedSize<N2dest->NbRow+CopiedRows) {
-			N2dest->ReservedSize=N2dest->NbRow+CopiedRows+1000;	// Too big, but doesn't matter. The constant is to limit the reallocations. Value is pulled out of my ass
-			N2dest->TimeStamp=realloc(N2dest->TimeStamp, N2dest->ReservedSize*sizeof(unsigned long long));
-			N2dest->Data     =realloc(N2dest->Data,      N2dest->ReservedSize*8);
-			if (N2dest->TimeStamp==NULL or N2dest->Data==NULL) { R=-ENOMEM; goto End; }
-			for (int i=N2dest->NbRow+1; i<N2dest->ReservedSize; i++) {
-				N2dest->TimeStamp[i]=0;	// This loop shouldn't be necessary
-				N2dest->Data[i]=NULL;
-			}
+	if (Decimation<=0) Decimation=1;
+	long long NbRow=N2source->NbRow;
+	if (NbRow<=0) return 0;
+	if (N2dest->NbCol!=N2source->NbCol) return -(errno=EINVAL);	// Columns are copied one by one
+	if (MaxRows>0 and N2dest->NbRow>=MaxRows) return 0;	// Already over
+	
+	long long First=(Decimation-*Remaining)%Decimation;	// Skip the 1st points
+	*Remaining=(int)((NbRow /*-Decimation*/ + *Remaining)%Decimation);	// Number of remaining points before next decimation
+	
+	// Rows First+k*Decimation within [Lo, Hi[
+	long long Lo=(TimeStampLow ==0 ? 0     : LowerBound(N2source->TimeStamp, NbRow, TimeStampLow));
+	long long Hi=(TimeStampHigh==0 ? NbRow : LowerBound(N2source->TimeStamp, NbRow, TimeStampHigh+1));
+	if (Lo<First) Lo=First;
+	if (Lo>=Hi) return 0;
+	long long S0=First+(Lo-First+Decimation-1)/Decimation*Decimation;	// 1st source row to copy
+	if (S0>=Hi) return 0;
+	long long Count=(Hi-1-S0)/Decimation+1;
+	if (MaxRows>0 and Count>MaxRows-N2dest->NbRow) Count=MaxRows-N2dest->NbRow;
+	
+	long long D0=N2dest->NbRow;
+	if (N2dest->ReservedSize<D0+Count) {	// Geometric growth, so that merging many files stays linear
+		long long NewSize=2*N2dest->ReservedSize;
+		if (NewSize<D0+Count) NewSize=D0+Count;
+		int R=ReserveRows(N2dest, NewSize);
+		if (R<0) return R;
+	}
+	
+	for (long long i=0, S=S0; i<Count; i++, S+=Decimation)
+		N2dest->TimeStamp[D0+i]=N2source->TimeStamp[S];
+	if (N2dest->Columnar)
+		for (int c=0; c<N2dest->NbCol; c++) {
+			long long *Dst=(long long*)N2dest->Cols[c]+D0;
+			if (N2source->Columnar) {
+				const long long *Src=N2source->Cols[c];
+				for (long long i=0, S=S0; i<Count; i++, S+=Decimation) Dst[i]=Src[S];
+			} else 
+				for (long long i=0, S=S0; i<Count; i++, S+=Decimation) Dst[i]=((long long**)N2source->Data)[S][c];
 		}
-		for (int i=0; i<CopiedRows; i++) {
-			if (MaxRows>0 and N2dest->NbRow>=MaxRows) { 
-				// Because we need to free the N2source->Data[..] which we aren't moving to N2dest
-				if (TempData[i]) { free(TempData[i]); TempData[i]=NULL; NbFree++; }
-				continue;
-			}
-			N2dest->TimeStamp[N2dest->NbRow] = TempTimeStamp[i];
-			N2dest->Data     [N2dest->NbRow] = TempData     [i];
-			TempData[i]=NULL;	// So that ClearConfig won't free the transfered destination
-//			memcpy(N2dest->Data[N2dest->NbRow+i],TempData     [i], N2source->NbCol*sizeof(double));
-			AddedRows++;
-			N2dest->NbRow++;
+	else if (!N2source->Columnar and !N2source->UseArena and !N2dest->UseArena)
+		for (long long i=0, S=S0; i<Count; i++, S+=Decimation) {
+			N2dest->Data[D0+i] = N2source->Data[S];	// Point to same thing
+			N2source->Data[S]=NULL;	// So that ClearConfig won't free the transfered destination
 		}
-		R=AddedRows;
+	else for (long long i=0, S=S0; i<Count; i++, S+=Decimation) {	// Rows belonging to an arena cannot be moved
+		long long *Row=N2alloc(N2dest, N2dest->NbCol*8);
+		if (Row==NULL) { N2dest->NbRow=D0+i; return -(errno=ENOMEM); }
+		if (!N2dest->UseArena) __sync_fetch_and_add(&NbAlloc, 1);
+		for (int c=0; c<N2dest->NbCol; c++) Row[c]=N2_CELL(N2source, S, c, long long);
+		N2dest->Data[D0+i]=Row;
 	}
-	
-End:
-	if (TempTimeStamp!=NULL) free(TempTimeStamp);
-	if (TempData     !=NULL) free(TempData);
-	return R;
+	N2dest->NbRow=D0+Count;
+	return Count;
 }
 
 
 
 ///////////////////////////////////////////////////////////////////////////////
-/// HIFN	Read the actual EDMdat file
-/// HIPAR	PathName / Name of .EDMdat file
-/// HIPAR	N2data / Structure already read and set by ReadConfigData()
-/// HIPAR	N2data / Set N2data->NbRow to -1 if you want this function to JUST return the expected number of rows without reading any data
-/// HIPAR	AltFirstTimeStamp / Pass 0 to use the 1st timestamp of the file as the zero reference for relative time
-/// HIPAr	AltFirstTimeStamp / Or when merging multiple cycle files, pass the timestamp of the 1st file
-/// HIRET	-errno or number of rows
+/// HIFN	Address of a cell whatever the layout, the row being allocated
 ///////////////////////////////////////////////////////////////////////////////
-static int ReadData(const char* PathName, tN2data *N2data, long long AltFirstTimeStamp) {
-	SLOG(SDBG, "Enter: %s", PathName);
-
-	errno=0;
-	FILE* fd=fopen(PathName, "rb");
-	if (fd==NULL) {
-		SLOG(SERR, "Could not open data file %s: %s", PathName, strerror(errno));
-		return -errno;
-	}
-
-	// Get file size
-	fseek(fd, 0, SEEK_END);
-	int Size = ftell(fd);
-	int ExpectRows=Size/((N2data->NbCol+1)*sizeof(double));	// Includes Reltime and EOF marker
-	SLOG(SNTC, "ExpectRows=%d", ExpectRows);
-	if (N2data->NbRow==-1) { fclose(fd); return N2data->NbRow=ExpectRows; }
-
-	rewind(fd);
+static inline long long* CellPtr(tN2data *N2data, long long Row, int Col) {
+	return N2data->Columnar ? (long long*)N2data->Cols[Col]+Row : (long long*)N2data->Data[Row]+Col;
+}
 
-	N2data->DataPathname=strdup(PathName);
-	if (N2data->DataPathname==NULL) { SLOG(SERR, "Out of memory"); return -(errno=ENOMEM); }
+typedef void (*tMinMaxKernel)(const void *Col, long long Nb, void *Min, void *Max);	// See GetMinMaxKernels()
+static void GetMinMaxKernels(tMinMaxKernel *Double, tMinMaxKernel *U64);
 
-	// Print presentation header
-	//	printf("%s", N2data->Labels[0]);
-	char Buf[1024*1024]="RelTime (s)";	// WARNING: default java stack size is very small, only 320Kb !!! Use -Xss4m
-	if (N2data->Columns[0].DataType) free(N2data->Columns[0].DataType);
-	N2data->Columns[0].DataType=strdup("double");	// Converted to seconds (string is already allocated as uint64)
-	if (N2data->Columns[0].DataType==NULL) { SLOG(SERR, "Out of memory"); return -(errno=ENOMEM); }
-	//	if (N2data->Columns[0].Description) free(N2data->Columns[0].Description);
-	strcpy(N2data->Columns[0].Description, "[s]");	// Change unit ns->s
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	Envelope decimation, for plotting many rows without losing the spikes: 
+/// HIFN	the source rows are cut in buckets and each bucket gives the min and max of every column 
+/// HIFN	(N2_ENV_MINMAX, 2 rows) or its first, min, max and last rows (N2_ENV_M4, 4 rows)
+/// HIFN	The min and max rows carry the timestamp and RelTime of the middle of the bucket
+/// HIFN	Computed in one pass, vectorized on a columnar source. A bucket without any valid double gives NaN
+/// HIPAR	Mode / N2_ENV_MINMAX or N2_ENV_M4
+/// HIPAR	Decimation / Number of source rows per bucket, or 0 to compute it from MaxRows
+/// HIPAR	MaxRows / Max number of rows in N2dest (0 for no limit)
+/// HIPAR	TimeStampLow / Only use the source rows with TimeStampLow<=TimeStamp<=TimeStampHigh. 0 for no limit
+/// HIRET	Number of effectively added rows (or -errno)
+///////////////////////////////////////////////////////////////////////////////
+long long N2_AddDataEnvelope(tN2data *N2dest, tN2data *N2source, int Mode, 
+				int Decimation, long long MaxRows, 
+				long long TimeStampLow, long long TimeStampHigh) {
+	int Per=(Mode==N2_ENV_M4 ? 4 : 2);	// Rows per bucket
+	long long NbRow=N2source->NbRow;
+	if (NbRow<=0) return 0;
+	if (N2dest->NbCol!=N2source->NbCol) return -(errno=EINVAL);
+	long long Lo=(TimeStampLow ==0 ? 0     : LowerBound(N2source->TimeStamp, NbRow, TimeStampLow));
+	long long Hi=(TimeStampHigh==0 ? NbRow : LowerBound(N2source->TimeStamp, NbRow, TimeStampHigh+1));
+	if (Lo>=Hi) return 0;
 	
-	// Skip this block if not in debug mode
-	int ShowDebug=SimpleLog_FilterLevel(-1)&SL_DEBUG;
-	if (ShowDebug) {
-		for (int i=1; i<N2data->NbCol; i++) sprintf(Buf+strlen(Buf), ", %s", N2data->Labels[i]);
-		SLOG(SDBG, "%s", Buf);
+	long long MaxBuckets=(MaxRows>0 ? (MaxRows-N2dest->NbRow)/Per : Hi-Lo);
+	if (MaxBuckets<=0) return 0;
+	long long Bucket=(Decimation>0 ? Decimation : (Hi-Lo+MaxBuckets-1)/MaxBuckets);
+	long long NbBuckets=(Hi-Lo+Bucket-1)/Bucket;
+	if (NbBuckets>MaxBuckets) NbBuckets=MaxBuckets;
+	long long Count=NbBuckets*Per, D0=N2dest->NbRow;
+	
+	if (N2dest->ReservedSize<D0+Count) {	// Geometric growth, as in N2_AddDataWithFilter()
+		long long NewSize=2*N2dest->ReservedSize;
+		if (NewSize<D0+Count) NewSize=D0+Count;
+		int R=ReserveRows(N2dest, NewSize);
+		if (R<0) return R;
 	}
-		 
-	N2data->TimeStamp=calloc(ExpectRows, sizeof(long long));
-//	N2data->Data     =calloc((N2data->NbCol-1)*ExpectRows, sizeof(double));
-	N2data->Data     =calloc(ExpectRows, sizeof(void*));
-	if (N2data->TimeStamp==NULL or N2data->Data==NULL) return -(errno=ENOMEM);
-	int R=0;
-	unsigned long long Eol;
-	N2data->NbRow=N2data->ReservedSize=0;
-	do {
-		// First the timestamp
-		R=fread(&N2data->TimeStamp[N2data->NbRow],   sizeof(long long), 1, fd);
-		if (R!=1) { SLOG(SWRN, "Unexpected end of file: R=%i (expecting %i)", R, N2data->NbCol-1); break; }
-		N2data->Data[N2data->NbRow]=calloc(N2data->NbCol, 8); NbAlloc++;
-		if (N2data->Data[N2data->NbRow]==NULL) return -(errno=ENOMEM);
-		((double**)N2data->Data)[N2data->NbRow][0] = NANO_TO_SEC(N2data->TimeStamp[N2data->NbRow] - (AltFirstTimeStamp==0?N2data->FirstTimeStamp:AltFirstTimeStamp));	// convert to seconds
-
-		// Then the rest of the data
-		R=fread((long long*)(N2data->Data[N2data->NbRow])+1, 8, N2data->NbCol-1, fd);	// either double or uint64
-		if (R!=N2data->NbCol-1) { SLOG(SWRN, "Unexpected end of file: R=%i (expecting %i)", R, N2data->NbCol-1); break; }
-
-		R=fread(&Eol, sizeof(Eol), 1, fd);
-		if (R!=1) { SLOG(SWRN, "Unexpected end of file: R=%i (expecting %i)", R, N2data->NbCol-1); break; }
-
-		if (ShowDebug) {	// Skip this block if not in debug mode
-			sprintf(Buf, "%.3f", ((double**)N2data->Data)[N2data->NbRow][0]);
-			for (int i=1; i<N2data->NbCol; i++) 
-				if (0==strcmp(N2data->Columns[i].DataType, "double")) 
-					 sprintf(Buf+strlen(Buf),  ", %.3g", ((   double**)N2data->Data)[N2data->NbRow][i]);
-				else sprintf(Buf+strlen(Buf),  ", %lli", ((long long**)N2data->Data)[N2data->NbRow][i]);
-			sprintf(Buf+strlen(Buf), ", 0x%llX", Eol);
-			SLOG(SDBG, "%.1000s", Buf);
+	if (!N2dest->Columnar)
+		for (long long i=0; i<Count; i++) {
+			if (NULL==(N2dest->Data[D0+i]=N2alloc(N2dest, N2dest->NbCol*8))) { N2dest->NbRow=D0+i; return -(errno=ENOMEM); }
+			if (!N2dest->UseArena) __sync_fetch_and_add(&NbAlloc, 1);
 		}
-		
-		if (Eol!=N2data->EOLidentifier)
-			SLOG(SERR, "EOL is wrong: 0x%llX (expecting 0x%llX)", Eol, N2data->EOLidentifier);
+	N2dest->NbRow=D0+Count;	// So that the rows are freed even on error
 
-		N2data->NbRow++;
-	} while (N2data->NbRow<ExpectRows);
-	
-	N2data->ReservedSize=N2data->NbRow;
+	tMinMaxKernel KDouble, KU64;
+	GetMinMaxKernels(&KDouble, &KU64);
+	int IsDouble[N2source->NbCol];
+	for (int c=0; c<N2source->NbCol; c++) IsDouble[c]=(0==strcmp(N2source->Columns[c].DataType, "double"));
 	
-	if (N2data->NbRow!=ExpectRows) 
-		 SLOG(SERR, "Row number discrepancy: %d!=%d", N2data->NbRow, ExpectRows);
-	else SLOG(SNTC, "NbRow=%d", N2data->NbRow);
-	
-	fclose(fd); fd=NULL;
-	
-	if (errno) SLOG(SERR, "Error on data file %s: %s", PathName, strerror(errno));
+	for (long long b=0; b<NbBuckets; b++) {
+		long long S=Lo+b*Bucket, E=(S+Bucket<Hi ? S+Bucket : Hi), Mid=S+(E-S-1)/2, D=D0+b*Per;
+		long long MinRow=D+(Per==4), MaxRow=MinRow+1;
+		// Rows carry the timestamp and RelTime (column 0) of the source row they stand for
+		long long Src[4]={S, Mid, Mid, E-1}, *SrcRow=(Per==4 ? Src : Src+1);
+		for (int k=0; k<Per; k++) {
+			N2dest->TimeStamp[D+k]=N2source->TimeStamp[SrcRow[k]];
+			*CellPtr(N2dest, D+k, 0)=N2_CELL(N2source, SrcRow[k], 0, long long);
+		}
+		for (int c=1; c<N2source->NbCol; c++) {
+			long long *Min=CellPtr(N2dest, MinRow, c), *Max=CellPtr(N2dest, MaxRow, c);
+			if (N2source->Columnar) 
+				(IsDouble[c] ? KDouble : KU64)((long long*)N2source->Cols[c]+S, E-S, Min, Max);
+			else if (IsDouble[c]) {
+				double L=INFINITY, H=-INFINITY;
+				for (long long r=S; r<E; r++) {
+					double V=N2_CELL(N2source, r, c, double);
+					if (V<L) L=V;
+					if (V>H) H=V;
+				}
+				*(double*)Min=L; *(double*)Max=H;
+			} else {
+				unsigned long long L=~0ULL, H=0;
+				for (long long r=S; r<E; r++) {
+					unsigned long long V=N2_CELL(N2source, r, c, long long);
+					if (V<L) L=V;
+					if (V>H) H=V;
+				}
+				*(unsigned long long*)Min=L; *(unsigned long long*)Max=H;
+			}
+			if (IsDouble[c] and *(double*)Min>*(double*)Max) *(double*)Min=*(double*)Max=NAN;	// Only NaNs
+			if (Per==4) {
+				*CellPtr(N2dest, D,   c)=N2_CELL(N2source, S,   c, long long);
+				*CellPtr(N2dest, D+3, c)=N2_CELL(N2source, E-1, c, long long);
+			}
+		}
+	}
+	return Count;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	As-of join of several datasets (ex: hgm, coils and temperature of the same cycle) into one table.
+/// HIFN	Each output row has a timestamp, the RelTime from the FirstTimeStamp of the 1st input, 
+/// HIFN	then the columns 1.. of every input, taken from its latest row at or before that timestamp
+/// HIFN	The inputs are walked once in time order, so the cost is in the total number of rows
+/// HIPAR	N2dest / Receives the table. Set its Columnar and UseArena options before the call
+/// HIPAR	Inputs / NbInputs datasets sorted by time, already read. They are not modified
+/// HIPAR	Tolerance / Max age in ns of a matched row: 0 for an exact match, -1 (any <0) for no limit. Without a match, 
+/// HIPAR	Tolerance / double columns get NaN and uint64 columns get N2_JOIN_MISSING
+/// HIPAR	Union / 0: one row per row of Inputs[0], which gives its own columns even for duplicate timestamps
+/// HIPAR	Union / 1: one row per distinct timestamp of all inputs (k-way merge)
+/// HIRET	Number of rows (or -errno)
+///////////////////////////////////////////////////////////////////////////////
+long long N2_JoinAsOf(tN2data *N2dest, tN2data *Inputs[], int NbInputs, long long Tolerance, int Union) {
+	if (N2dest==NULL or Inputs==NULL or NbInputs<1) return -(errno=EINVAL);
+	long long Total=0;
+	int NbCol=1;
+	for (int k=0; k<NbInputs; k++) {
+		if (Inputs[k]==NULL or Inputs[k]==N2dest or Inputs[k]->NbCol<1 or Inputs[k]->NbRow<0) return -(errno=EINVAL);
+		Total+=Inputs[k]->NbRow;
+		NbCol+=Inputs[k]->NbCol-1;
+	}
+	long long NbOut=(Union ? Total : Inputs[0]->NbRow);	// Upper bound with Union
+	
+	// Header: the columns of all inputs, named after their subsystem
+	ClearConfig(N2dest, 1);
+	N2dest->Columns=N2alloc(N2dest, NbCol*sizeof(tColumn));
+	N2dest->Labels =N2alloc(N2dest, NbCol*sizeof(char*));
+	if (N2dest->Columns==NULL or N2dest->Labels==NULL) return -(errno=ENOMEM);
+	N2dest->NbCol=NbCol;
+	tColumn *C0=&Inputs[0]->Columns[0];
+	N2dest->Columns[0]=(tColumn){ N2strdup(N2dest, C0->Name ? C0->Name : "timeStamp"), N2strdup(N2dest, "[s]"), N2strdup(N2dest, "double") };
+	N2dest->Labels [0]=N2strdup(N2dest, "RelTime (s)");
+	char Name[1024]="";
+	for (int k=0, c=1; k<NbInputs; k++) {
+		const char *Subs=(Inputs[k]->Name ? Inputs[k]->Name : "?");
+		snprintf(Name+strlen(Name), sizeof(Name)-strlen(Name), "%s%s", k?"+":"", Subs);
+		for (int i=1; i<Inputs[k]->NbCol; i++, c++) {
+			const tColumn *Src=&Inputs[k]->Columns[i];
+			char *ColName=N2alloc(N2dest, strlen(Subs)+strlen(Src->Name)+2);
+			if (ColName) sprintf(ColName, "%s.%s", Subs, Src->Name);
+			N2dest->Columns[c]=(tColumn){ ColName, N2strdup(N2dest, Src->Description), N2strdup(N2dest, Src->DataType) };
+			N2dest->Labels [c]=N2strdup(N2dest, Inputs[k]->Labels[i]);
+		}
+	}
+	N2dest->Name=N2strdup(N2dest, Name);
+	for (int c=0; c<NbCol; c++)
+		if (N2dest->Labels[c]==NULL or N2dest->Columns[c].Name==NULL or N2dest->Columns[c].Description==NULL or N2dest->Columns[c].DataType==NULL) 
+			return -(errno=ENOMEM);
+	if (N2dest->Name==NULL) return -(errno=ENOMEM);
+	N2dest->RunNo=Inputs[0]->RunNo;
+	N2dest->CycNo=Inputs[0]->CycNo;
+	N2dest->EOLidentifier=Inputs[0]->EOLidentifier;
+	long long RefTimeStamp=Inputs[0]->FirstTimeStamp;
+	
+	if (AllocRows(N2dest, NbOut)<0) return -errno;
+	N2dest->ReservedSize=NbOut;
+	
+	long long Pos[NbInputs];	// For each input, number of rows at or before the current timestamp
+	int IsDouble[NbCol];
+	for (int k=0; k<NbInputs; k++) Pos[k]=0;
+	for (int c=0; c<NbCol; c++) IsDouble[c]=(0==strcmp(N2dest->Columns[c].DataType, "double"));
+	
+	long long r=0;
+	for (long long Drive=0; ; r++) {
+		long long T=0;
+		if (!Union) {
+			if (Drive>=Inputs[0]->NbRow) break;
+			T=Inputs[0]->TimeStamp[Drive++];
+		} else {	// Smallest next timestamp of all inputs
+			int Found=0;
+			for (int k=0; k<NbInputs; k++) 
+				if (Pos[k]<Inputs[k]->NbRow and (!Found or Inputs[k]->TimeStamp[Pos[k]]<T)) { T=Inputs[k]->TimeStamp[Pos[k]]; Found=1; }
+			if (!Found) break;
+		}
+		if (!N2dest->Columnar and N2dest->Data[r]==NULL) {
+			if (NULL==(N2dest->Data[r]=N2alloc(N2dest, NbCol*8))) { N2dest->NbRow=r; return -(errno=ENOMEM); }
+			if (!N2dest->UseArena) __sync_fetch_and_add(&NbAlloc, 1);
+		}
+		N2dest->TimeStamp[r]=T;
+		*(double*)CellPtr(N2dest, r, 0)=NANO_TO_SEC(T-RefTimeStamp);
+		
+		for (int k=0, c=1; k<NbInputs; k++) {
+			tN2data *In=Inputs[k];
+			long long Row;
+			if (k==0 and !Union) Row=Pos[0]=Drive-1;	// The driving row itself, not the last of its duplicates
+			else {
+				while (Pos[k]<In->NbRow and In->TimeStamp[Pos[k]]<=T) Pos[k]++;
+				Row=Pos[k]-1;
+			}
+			int Match=(Row>=0 and (Tolerance<0 or T-In->TimeStamp[Row]<=Tolerance));
+			for (int i=1; i<In->NbCol; i++, c++)
+				if (Match) *CellPtr(N2dest, r, c)=N2_CELL(In, Row, i, long long);
+				else if (IsDouble[c]) *(double*)CellPtr(N2dest, r, c)=NAN;
+				else *CellPtr(N2dest, r, c)=(long long)N2_JOIN_MISSING;
+		}
+	}
+	N2dest->NbRow=r;
+	if (r>0) {
+		N2dest->FirstTimeStamp=N2dest->TimeStamp[0];
+		N2dest->LastTimeStamp =N2dest->TimeStamp[r-1];
+	}
+	return r;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Vectorized kernels for DecodeBlock(): extract the timestamps, check the EOL markers 
+// and compute the relative time over a whole block. AVX2 or SSE2, chosen at runtime
+///////////////////////////////////////////////////////////////////////////////
+
+#define N2_MAX_BAD_LOG 10	// Number of wrong EOL positions reported per block
+
+/// HIPAR	W / Record width in 8-byte words
+/// HIPAR	EolCol / Position of the EOL in the record
+/// HIPAR	RelTime / Optional, receives NANO_TO_SEC(TimeStamp-RefTimeStamp)
+/// HIPAR	BadRows / Receives the index in the block of the first MaxBad wrong EOL markers
+/// HIRET	Number of wrong EOL markers
+typedef int (*tBlockKernel)(const long long *Block, int NbRec, int W, int EolCol, unsigned long long EOLidentifier, 
+							long long *TimeStamp, double *RelTime, long long RefTimeStamp, int *BadRows, int MaxBad);
+
+///////////////////////////////////////////////////////////////////////////////
+static int BlockKernelScalar(const long long *Block, int NbRec, int W, int EolCol, unsigned long long EOLidentifier, 
+							 long long *TimeStamp, double *RelTime, long long RefTimeStamp, int *BadRows, int MaxBad) {
+	int NbBad=0;
+	for (int r=0; r<NbRec; r++) {
+		TimeStamp[r]=Block[(long long)r*W];
+		if ((unsigned long long)Block[(long long)r*W+EolCol]!=EOLidentifier) {
+			if (NbBad<MaxBad) BadRows[NbBad]=r;
+			NbBad++;
+		}
+	}
+	if (RelTime) for (int r=0; r<NbRec; r++) RelTime[r]=NANO_TO_SEC(TimeStamp[r]-RefTimeStamp);	// convert to seconds
+	return NbBad;
+}
+
+#if defined(__x86_64__) or defined(__i386__)
+#include <immintrin.h>
+
+// int64 to double without AVX-512: exact for |x|<2^51 by adding the bits of 1.5*2^52, 
+// which is always the case for the relative time in ns of a run (26 days)
+#define MAGIC_2P52 0x1.8p52
+#define MAGIC_LIM  (1LL<<51)
+
+///////////////////////////////////////////////////////////////////////////////
+__attribute__((target("sse2")))
+static int BlockKernelSSE2(const long long *Block, int NbRec, int W, int EolCol, unsigned long long EOLidentifier, 
+						   long long *TimeStamp, double *RelTime, long long RefTimeStamp, int *BadRows, int MaxBad) {
+	const __m128i Eol=_mm_set1_epi64x(EOLidentifier);
+	int r=0, NbBad=0;
+	for (; r+2<=NbRec; r+=2) {	// No gather in SSE2, but the compare is vectorized
+		const long long *B=Block+(long long)r*W;
+		_mm_storeu_si128((__m128i*)(TimeStamp+r), _mm_set_epi64x(B[W], B[0]));
+		__m128i Eq=_mm_cmpeq_epi32(_mm_set_epi64x(B[W+EolCol], B[EolCol]), Eol);	// No 64-bit compare in SSE2
+		Eq=_mm_and_si128(Eq, _mm_shuffle_epi32(Eq, _MM_SHUFFLE(2,3,0,1)));
+		int Mask=_mm_movemask_pd(_mm_castsi128_pd(Eq));
+		if (Mask!=0x3) for (int k=0; k<2; k++)
+			if (!(Mask>>k & 1)) { if (NbBad<MaxBad) BadRows[NbBad]=r+k; NbBad++; }
+	}
+	if (r<NbRec) {
+		int Bad[1], N=BlockKernelScalar(Block+(long long)r*W, NbRec-r, W, EolCol, EOLidentifier, TimeStamp+r, NULL, 0, Bad, 1);
+		if (N) { if (NbBad<MaxBad) BadRows[NbBad]=r; NbBad++; }
+	}
+	
+	if (RelTime) {
+		const __m128i Magic=_mm_castpd_si128(_mm_set1_pd(MAGIC_2P52));
+		const __m128d MagicD=_mm_set1_pd(MAGIC_2P52), Giga=_mm_set1_pd(1e9);
+		for (r=0; r+2<=NbRec; r+=2) {
+			long long D0=TimeStamp[r]-RefTimeStamp, D1=TimeStamp[r+1]-RefTimeStamp;
+			if (D0<=-MAGIC_LIM or D0>=MAGIC_LIM or D1<=-MAGIC_LIM or D1>=MAGIC_LIM) {
+				RelTime[r]=NANO_TO_SEC(D0); RelTime[r+1]=NANO_TO_SEC(D1); continue; }
+			__m128d D=_mm_sub_pd(_mm_castsi128_pd(_mm_add_epi64(_mm_set_epi64x(D1, D0), Magic)), MagicD);
+			_mm_storeu_pd(RelTime+r, _mm_div_pd(D, Giga));	// Division, so identical to NANO_TO_SEC()
+		}
+		for (; r<NbRec; r++) RelTime[r]=NANO_TO_SEC(TimeStamp[r]-RefTimeStamp);
+	}
+	return NbBad;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+__attribute__((target("avx2")))
+static int BlockKernelAVX2(const long long *Block, int NbRec, int W, int EolCol, unsigned long long EOLidentifier, 
+						   long long *TimeStamp, double *RelTime, long long RefTimeStamp, int *BadRows, int MaxBad) {
+	const __m256i Idx=_mm256_set_epi64x(3LL*W, 2LL*W, W, 0), Eol=_mm256_set1_epi64x(EOLidentifier);
+	int r=0, NbBad=0;
+	for (; r+4<=NbRec; r+=4) {
+		const long long *B=Block+(long long)r*W;
+		_mm256_storeu_si256((__m256i*)(TimeStamp+r), _mm256_i64gather_epi64(B, Idx, 8));
+		__m256i Eq=_mm256_cmpeq_epi64(_mm256_i64gather_epi64(B+EolCol, Idx, 8), Eol);
+		int Mask=_mm256_movemask_pd(_mm256_castsi256_pd(Eq));
+		if (Mask!=0xF) for (int k=0; k<4; k++)
+			if (!(Mask>>k & 1)) { if (NbBad<MaxBad) BadRows[NbBad]=r+k; NbBad++; }
+	}
+	for (; r<NbRec; r++) {
+		TimeStamp[r]=Block[(long long)r*W];
+		if ((unsigned long long)Block[(long long)r*W+EolCol]!=EOLidentifier) { if (NbBad<MaxBad) BadRows[NbBad]=r; NbBad++; }
+	}
+	
+	if (RelTime) {
+		const __m256i Ref=_mm256_set1_epi64x(RefTimeStamp), 
+					  Magic=_mm256_castpd_si256(_mm256_set1_pd(MAGIC_2P52)),
+					  Lo=_mm256_set1_epi64x(-MAGIC_LIM), Hi=_mm256_set1_epi64x(MAGIC_LIM);
+		const __m256d MagicD=_mm256_set1_pd(MAGIC_2P52), Giga=_mm256_set1_pd(1e9);
+		for (r=0; r+4<=NbRec; r+=4) {
+			__m256i D=_mm256_sub_epi64(_mm256_loadu_si256((const __m256i*)(TimeStamp+r)), Ref);
+			__m256i In=_mm256_and_si256(_mm256_cmpgt_epi64(D, Lo), _mm256_cmpgt_epi64(Hi, D));
+			if (_mm256_movemask_pd(_mm256_castsi256_pd(In))!=0xF) {
+				for (int k=0; k<4; k++) RelTime[r+k]=NANO_TO_SEC(TimeStamp[r+k]-RefTimeStamp);
+				continue; }
+			__m256d F=_mm256_sub_pd(_mm256_castsi256_pd(_mm256_add_epi64(D, Magic)), MagicD);
+			_mm256_storeu_pd(RelTime+r, _mm256_div_pd(F, Giga));	// Division, so identical to NANO_TO_SEC()
+		}
+		for (; r<NbRec; r++) RelTime[r]=NANO_TO_SEC(TimeStamp[r]-RefTimeStamp);
+	}
+	return NbBad;
+}
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	Select the best kernel for this CPU, only once
+///////////////////////////////////////////////////////////////////////////////
+static tBlockKernel GetBlockKernel(void) {
+	static tBlockKernel Kernel=NULL;	// Atomic: several threads can select it at once, they all find the same one
+	tBlockKernel K=__atomic_load_n(&Kernel, __ATOMIC_ACQUIRE);
+	if (K==NULL) {
+#if defined(__x86_64__) or defined(__i386__)
+		__builtin_cpu_init();
+		K = __builtin_cpu_supports("avx2") ? BlockKernelAVX2 : 
+			__builtin_cpu_supports("sse2") ? BlockKernelSSE2 : BlockKernelScalar;
+#else
+		K = BlockKernelScalar;
+#endif
+		__atomic_store_n(&Kernel, K, __ATOMIC_RELEASE);
+	}
+	return K;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Min/max kernels for N2_AddDataEnvelope(), over a contiguous column. NaNs are ignored
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+static void MinMaxDoubleScalar(const void *Col, long long Nb, void *Min, void *Max) {
+	const double *V=Col;
+	double Lo=INFINITY, Hi=-INFINITY;
+	for (long long i=0; i<Nb; i++) {
+		if (V[i]<Lo) Lo=V[i];
+		if (V[i]>Hi) Hi=V[i];
+	}
+	*(double*)Min=Lo; *(double*)Max=Hi;
+}
+
+static void MinMaxU64Scalar(const void *Col, long long Nb, void *Min, void *Max) {
+	const unsigned long long *V=Col;
+	unsigned long long Lo=~0ULL, Hi=0;
+	for (long long i=0; i<Nb; i++) {
+		if (V[i]<Lo) Lo=V[i];
+		if (V[i]>Hi) Hi=V[i];
+	}
+	*(unsigned long long*)Min=Lo; *(unsigned long long*)Max=Hi;
+}
+
+#if defined(__x86_64__) or defined(__i386__)
+///////////////////////////////////////////////////////////////////////////////
+__attribute__((target("sse2")))
+static void MinMaxDoubleSSE2(const void *Col, long long Nb, void *Min, void *Max) {
+	const double *V=Col;
+	__m128d Lo=_mm_set1_pd(INFINITY), Hi=_mm_set1_pd(-INFINITY);
+	long long i=0;
+	for (; i+2<=Nb; i+=2) {	// minpd returns the 2nd operand when one is NaN, so the NaNs are skipped
+		__m128d X=_mm_loadu_pd(V+i);
+		Lo=_mm_min_pd(X, Lo); Hi=_mm_max_pd(X, Hi);
+	}
+	double L[2], H[2], Tl, Th;
+	_mm_storeu_pd(L, Lo); _mm_storeu_pd(H, Hi);
+	MinMaxDoubleScalar(V+i, Nb-i, &Tl, &Th);
+	*(double*)Min=fmin(fmin(L[0], L[1]), Tl); *(double*)Max=fmax(fmax(H[0], H[1]), Th);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+__attribute__((target("avx2")))
+static void MinMaxDoubleAVX2(const void *Col, long long Nb, void *Min, void *Max) {
+	const double *V=Col;
+	__m256d Lo=_mm256_set1_pd(INFINITY), Hi=_mm256_set1_pd(-INFINITY);
+	long long i=0;
+	for (; i+4<=Nb; i+=4) {
+		__m256d X=_mm256_loadu_pd(V+i);
+		Lo=_mm256_min_pd(X, Lo); Hi=_mm256_max_pd(X, Hi);
+	}
+	double L[4], H[4], Tl, Th;
+	_mm256_storeu_pd(L, Lo); _mm256_storeu_pd(H, Hi);
+	MinMaxDoubleScalar(V+i, Nb-i, &Tl, &Th);
+	*(double*)Min=fmin(fmin(fmin(L[0], L[1]), fmin(L[2], L[3])), Tl);
+	*(double*)Max=fmax(fmax(fmax(H[0], H[1]), fmax(H[2], H[3])), Th);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+__attribute__((target("avx2")))
+static void MinMaxU64AVX2(const void *Col, long long Nb, void *Min, void *Max) {
+	const unsigned long long *V=Col;
+	const __m256i Sign=_mm256_set1_epi64x(0x8000000000000000LL);	// Unsigned compare with the signed one
+	__m256i Lo=_mm256_set1_epi64x(0x7FFFFFFFFFFFFFFFLL), Hi=_mm256_set1_epi64x(0x8000000000000000LL);
+	long long i=0;
+	for (; i+4<=Nb; i+=4) {
+		__m256i X=_mm256_xor_si256(_mm256_loadu_si256((const __m256i*)(V+i)), Sign);
+		Lo=_mm256_blendv_epi8(Lo, X, _mm256_cmpgt_epi64(Lo, X));
+		Hi=_mm256_blendv_epi8(Hi, X, _mm256_cmpgt_epi64(X, Hi));
+	}
+	unsigned long long L[4], H[4], Tl, Th;
+	_mm256_storeu_si256((__m256i*)L, _mm256_xor_si256(Lo, Sign));
+	_mm256_storeu_si256((__m256i*)H, _mm256_xor_si256(Hi, Sign));
+	MinMaxU64Scalar(V+i, Nb-i, &Tl, &Th);
+	for (int k=0; k<4; k++) { if (L[k]<Tl) Tl=L[k]; if (H[k]>Th) Th=H[k]; }
+	*(unsigned long long*)Min=Tl; *(unsigned long long*)Max=Th;
+}
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	Select the best min/max kernels for this CPU, only once
+///////////////////////////////////////////////////////////////////////////////
+static void GetMinMaxKernels(tMinMaxKernel *Double, tMinMaxKernel *U64) {
+	static tMinMaxKernel KD=NULL, KU=NULL;	// Atomic as in GetBlockKernel(), KD is stored last
+	tMinMaxKernel D=__atomic_load_n(&KD, __ATOMIC_ACQUIRE), U;
+	if (D==NULL) {
+#if defined(__x86_64__) or defined(__i386__)
+		__builtin_cpu_init();
+		U = __builtin_cpu_supports("avx2") ? MinMaxU64AVX2    : MinMaxU64Scalar;
+		D = __builtin_cpu_supports("avx2") ? MinMaxDoubleAVX2 : 
+			__builtin_cpu_supports("sse2") ? MinMaxDoubleSSE2 : MinMaxDoubleScalar;
+#else
+		U = MinMaxU64Scalar;
+		D = MinMaxDoubleScalar;
+#endif
+		__atomic_store_n(&KU, U, __ATOMIC_RELAXED);
+		__atomic_store_n(&KD, D, __ATOMIC_RELEASE);
+	} else U=__atomic_load_n(&KU, __ATOMIC_RELAXED);
+	*Double=D; *U64=U;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	De-interleave raw records of (NbCol+1)*8 bytes: TimeStamp, NbCol-1 values, EOL
+/// HIFN	into TimeStamp[] and Data[][] or Cols[][], converting the RelTime column to seconds
+/// HIPAR	Block / NbRec consecutive records as read from the file
+/// HIPAR	Dest / Row index of the first record in N2data, which must have room for it
+/// HIPAR	RefTimeStamp / Zero reference of the relative time
+/// HIRET	Number of wrong EOL markers, or -errno
+///////////////////////////////////////////////////////////////////////////////
+static int DecodeBlock(tN2data *N2data, const long long *Block, int NbRec, long long Dest, long long RefTimeStamp) {
+	const int NbCol=N2data->NbCol, NbFileCol=FILE_NBCOL(N2data), W=NbFileCol+1;	// Record width in 8-byte words
+	const int *FileCol=N2data->FileCol;	// Projection, if any
+	long long *TimeStamp=N2data->TimeStamp+Dest;
+	int BadRows[N2_MAX_BAD_LOG];
+	
+	// Timestamps, EOL check and RelTime in one vectorized pass
+	int NbBad=GetBlockKernel()(Block, NbRec, W, NbFileCol, N2data->EOLidentifier, TimeStamp, 
+							   N2data->Columnar ? (double*)N2data->Cols[0]+Dest : NULL, RefTimeStamp, BadRows, N2_MAX_BAD_LOG);
+	for (int i=0; i<NbBad and i<N2_MAX_BAD_LOG; i++)
+		SLOG(SERR, "EOL is wrong at row %lld: 0x%llX (expecting 0x%llX)", 
+			 Dest+BadRows[i], Block[(long long)BadRows[i]*W+NbFileCol], N2data->EOLidentifier);
+	if (NbBad>N2_MAX_BAD_LOG) SLOG(SERR, "...and %d more wrong EOL in this block", NbBad-N2_MAX_BAD_LOG);
+	
+	if (N2data->Columnar) {
+		for (int c=1; c<NbCol; c++) {
+			long long *Col=(long long*)N2data->Cols[c]+Dest;	// either double or uint64
+			const long long *Src=Block+(FileCol ? FileCol[c] : c);
+			for (int r=0; r<NbRec; r++) Col[r]=Src[r*W];
+		}
+	} else for (int r=0; r<NbRec; r++) {
+		long long *Row=N2data->Data[Dest+r];	// Already set when using an arena
+		if (Row==NULL) {
+			if (NULL==(Row=N2data->Data[Dest+r]=malloc(NbCol*8))) return -(errno=ENOMEM);
+			__sync_fetch_and_add(&NbAlloc, 1);	// May be called from several threads
+		}
+		((double*)Row)[0]=NANO_TO_SEC(TimeStamp[r]-RefTimeStamp);
+		if (FileCol) for (int c=1; c<NbCol; c++) Row[c]=Block[r*W+FileCol[c]];
+		else memcpy(Row+1, Block+r*W+1, (NbCol-1)*8);
+	}
+	return NbBad;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	Keep only some columns of a config just read, before reading the data
+/// HIPAR	ColList / Comma separated list of column names or indices, ex: "ADC1,ADC2" or "1,2,7"
+/// HIPAR	ColList / The timestamp (column 0) is always kept first, duplicates are ignored
+/// HIRET	-errno or new number of columns
+///////////////////////////////////////////////////////////////////////////////
+static int ProjectColumns(tN2data *N2data, const char* ColList) {
+	int NbKeep=1, R=0;
+	int      *Keep      =N2alloc(N2data, N2data->NbCol*sizeof(int));	// Index in the data file
+	tColumn  *NewColumns=N2alloc(N2data, N2data->NbCol*sizeof(tColumn));
+	char    **NewLabels =N2alloc(N2data, N2data->NbCol*sizeof(char*));
+	char     *List=strdup(ColList), *Save=NULL;
+	if (Keep==NULL or NewColumns==NULL or NewLabels==NULL or List==NULL) { R=-(errno=ENOMEM); goto End; }
+
+	for (char *Tok=strtok_r(List, ", ", &Save); Tok!=NULL; Tok=strtok_r(NULL, ", ", &Save)) {
+		int c=-1;
+		if (strspn(Tok, "0123456789")==strlen(Tok)) c=atoi(Tok);
+		else for (int i=0; i<N2data->NbCol; i++)
+			if (0==strcmp(Tok, N2data->Columns[i].Name)) { c=i; break; }
+		if (c<0 or c>=N2data->NbCol) { SLOG(SERR, "Unknown column %s in %s", Tok, N2data->ConfigPathname); R=-(errno=EINVAL); goto End; }
+		int k=0;
+		while (k<NbKeep and Keep[k]!=c) k++;	// Includes the timestamp
+		if (k==NbKeep) Keep[NbKeep++]=c;
+	}
+
+	// Move the kept headers, free the others
+	for (int k=0; k<NbKeep; k++) {
+		NewColumns[k]=N2data->Columns[Keep[k]]; bzero(&N2data->Columns[Keep[k]], sizeof(tColumn));
+		NewLabels [k]=N2data->Labels [Keep[k]]; N2data->Labels[Keep[k]]=NULL;
+	}
+	for (int i=0; i<N2data->NbCol; i++) {
+		N2free(N2data, N2data->Columns[i].Name);
+		N2free(N2data, N2data->Columns[i].Description);
+		N2free(N2data, N2data->Columns[i].DataType);
+		N2free(N2data, N2data->Labels[i]);
+	}
+	N2free(N2data, N2data->Columns); N2data->Columns=NewColumns; NewColumns=NULL;
+	N2free(N2data, N2data->Labels ); N2data->Labels =NewLabels;  NewLabels =NULL;
+	N2free(N2data, N2data->FileCol);
+	N2data->FileCol=Keep; Keep=NULL;
+	N2data->NbFileCol=FILE_NBCOL(N2data);
+	R=N2data->NbCol=NbKeep;
+	SLOG(SNTC, "Keeping %d of %d columns", N2data->NbCol, N2data->NbFileCol);
+
+End:
+	N2free(N2data, Keep);
+	N2free(N2data, NewColumns);
+	N2free(N2data, NewLabels);
+	if (List      ) free(List);
+	return R;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	Column 0 of the data is the relative time in seconds, not the timestamp in ns
+/// HIRET	0 or -ENOMEM
+///////////////////////////////////////////////////////////////////////////////
+static int SetRelTimeColumn(tN2data *N2data) {
+	N2free(N2data, N2data->Columns[0].DataType);
+	N2data->Columns[0].DataType=N2strdup(N2data, "double");	// Converted to seconds (string is already allocated as uint64)
+	if (N2data->Columns[0].DataType==NULL) { SLOG(SERR, "Out of memory"); return -(errno=ENOMEM); }
+	//	if (N2data->Columns[0].Description) free(N2data->Columns[0].Description);
+	strcpy(N2data->Columns[0].Description, "[s]");	// Change unit ns->s
+	return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	Binary search in a data file, with positioned reads of the timestamps only
+/// HIPAR	RecSize / Size of a record in bytes
+/// HIRET	Index of the first row whose timestamp is >=TimeStamp (NbRec if none), or -errno
+///////////////////////////////////////////////////////////////////////////////
+static long long FindRow(int fd, size_t RecSize, long long NbRec, long long TimeStamp) {
+	long long Lo=0, Hi=NbRec;
+	while (Lo<Hi) {
+		long long Mid=Lo+(Hi-Lo)/2, T;
+		if (sizeof(T)!=pread(fd, &T, sizeof(T), Mid*RecSize)) return -(errno ? errno : EIO);
+		if (T<TimeStamp) Lo=Mid+1; else Hi=Mid;
+	}
+	return Lo;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	Allocate the arrays for NbRows rows in one go, in the layout requested by N2data->Columnar
+/// HIRET	-errno or 0
+///////////////////////////////////////////////////////////////////////////////
+static int AllocRows(tN2data *N2data, long long NbRows) {
+	if (N2data->Columnar) {	// One contiguous aligned array per column
+		N2data->TimeStamp=AlignedAlloc(NbRows*sizeof(long long));
+		N2data->Cols     =calloc(N2data->NbCol, sizeof(void*));
+		if (N2data->TimeStamp==NULL or N2data->Cols==NULL) return -(errno=ENOMEM);
+		for (int i=0; i<N2data->NbCol; i++)
+			if (NULL==(N2data->Cols[i]=AlignedAlloc(NbRows*8))) return -(errno=ENOMEM);
+	} else {
+		N2data->TimeStamp=calloc(NbRows, sizeof(long long));
+//		N2data->Data     =calloc((N2data->NbCol-1)*NbRows, sizeof(double));
+		N2data->Data     =calloc(NbRows, sizeof(void*));
+		if (N2data->TimeStamp==NULL or N2data->Data==NULL) return -(errno=ENOMEM);
+		if (N2data->UseArena) {	// All the rows in one slab instead of one malloc each
+			long long *Slab=ArenaAlloc(&N2data->Arena, NbRows*N2data->NbCol*8);
+			if (Slab==NULL) return -(errno=ENOMEM);
+			for (long long r=0; r<NbRows; r++) N2data->Data[r]=Slab+r*N2data->NbCol;
+		}
+	}
+	return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	Part of a data file to be read by ReadRange()
+///////////////////////////////////////////////////////////////////////////////
+typedef struct sReadJob {
+	tN2data *N2data;			// Destination, already allocated
+	int fd, RecSize, BlockRows;
+	long long FileRow;			// First row to read in the file
+	long long Dest;				// Where it goes in N2data
+	long long NbRows;			// Number of rows to read
+	long long RefTimeStamp;
+	char *DebugBuf;				// Non NULL to log every row
+	long long NbRead;			// Out: number of rows actually decoded
+	int NbBad, Err;				// Out: wrong EOL markers, errno
+} tReadJob;
+
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	Read and decode a range of rows with positioned reads, so several can run in parallel on the same fd
+/// HIFN	Thread function, Arg is a tReadJob
+///////////////////////////////////////////////////////////////////////////////
+static void* ReadRange(void* Arg) {
+	tReadJob *Job=Arg;
+	tN2data *N2data=Job->N2data;
+	long long *Block=AlignedAlloc((size_t)Job->BlockRows*Job->RecSize);
+	if (Block==NULL) { Job->Err=ENOMEM; return NULL; }
+	
+	while (Job->NbRead<Job->NbRows) {
+		int Want=(Job->NbRows-Job->NbRead<Job->BlockRows ? (int)(Job->NbRows-Job->NbRead) : Job->BlockRows);
+		ssize_t Got=pread(Job->fd, Block, (size_t)Want*Job->RecSize, (off_t)(Job->FileRow+Job->NbRead)*Job->RecSize);
+		if (Got<0) { Job->Err=errno; break; }
+		int NbRec=Got/Job->RecSize;	// A partial record will be read again
+		if (NbRec==0) { SLOG(SWRN, "Unexpected end of file: R=%zi (expecting %i)", Got, Want); break; }
+		int R=DecodeBlock(N2data, Block, NbRec, Job->Dest+Job->NbRead, Job->RefTimeStamp);
+		if (R<0) { Job->Err=-R; break; }
+		Job->NbBad+=R;
+
+		if (Job->DebugBuf)	// Skip this block if not in debug mode
+			for (int k=0; k<NbRec; k++) {
+				char *Buf=Job->DebugBuf;
+				long long r=Job->Dest+Job->NbRead+k;
+				sprintf(Buf, "%.3f", N2_CELL(N2data, r, 0, double));
+				for (int i=1; i<N2data->NbCol; i++) 
+					if (0==strcmp(N2data->Columns[i].DataType, "double")) 
+						 sprintf(Buf+strlen(Buf),  ", %.3g", N2_CELL(N2data, r, i, double));
+					else sprintf(Buf+strlen(Buf),  ", %lli", N2_CELL(N2data, r, i, long long));
+				sprintf(Buf+strlen(Buf), ", 0x%llX", Block[(k+1)*Job->RecSize/8-1]);	// EOL
+				SLOG(SDBG, "%.1000s", Buf);
+			}
+		Job->NbRead+=NbRec;
+	}
+	free(Block);
+	return NULL;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	Read the actual EDMdat file
+/// HIPAR	PathName / Name of .EDMdat file
+/// HIPAR	N2data / Structure already read and set by ReadConfigData()
+/// HIPAR	N2data / Set N2data->NbRow to -1 if you want this function to JUST return the expected number of rows without reading any data
+/// HIPAR	AltFirstTimeStamp / Pass 0 to use the 1st timestamp of the file as the zero reference for relative time
+/// HIPAr	AltFirstTimeStamp / Or when merging multiple cycle files, pass the timestamp of the 1st file
+/// HIPAR	TimeStampLow / Only read rows with TimeStampLow<=TimeStamp<=TimeStampHigh. 0 for no limit
+/// HIPAR	TimeStampLow / The rows are found by binary search, only the matching part of the file is read
+/// HIPAR	N2data / Set N2data->NbThreads>1 to read large files in parallel ranges. The result is identical
+/// HIRET	-errno or number of rows
+///////////////////////////////////////////////////////////////////////////////
+static long long ReadData(const char* PathName, tN2data *N2data, long long AltFirstTimeStamp, 
+						  long long TimeStampLow, long long TimeStampHigh) {
+	SLOG(SDBG, "Enter: %s", PathName);
+
+	errno=0;
+	int fd=open(PathName, O_RDONLY);	// No stdio: we read by big blocks with pread, possibly from several threads
+	if (fd<0) {
+		SLOG(SERR, "Could not open data file %s: %s", PathName, strerror(errno));
+		return -errno;
+	}
+
+	// Get file size, 64 bits
+	struct stat st;
+	if (fstat(fd, &st)) { SLOG(SERR, "Cannot stat %s: %s", PathName, strerror(errno)); close(fd); return -errno; }
+	long long Size = st.st_size;
+	long long ExpectRows=Size/((FILE_NBCOL(N2data)+1)*sizeof(double));	// Includes Reltime and EOF marker
+	SLOG(SNTC, "ExpectRows=%lld", ExpectRows);
+	if (N2data->NbRow==-1) { close(fd); return N2data->NbRow=ExpectRows; }
+
+	size_t RecSize=(FILE_NBCOL(N2data)+1)*8;
+	long long FirstRow=0;
+	if (TimeStampLow!=0 or TimeStampHigh!=0) {	// Timestamps are monotonic, so look for the matching rows
+		long long EndRow;
+		FirstRow=(TimeStampLow ==0 ? 0          : FindRow(fd, RecSize, ExpectRows, TimeStampLow));
+		EndRow  =(TimeStampHigh==0 ? ExpectRows : FindRow(fd, RecSize, ExpectRows, TimeStampHigh+1));
+		if (FirstRow<0 or EndRow<0) { close(fd); return FirstRow<0 ? FirstRow : EndRow; }
+		if (EndRow<FirstRow) EndRow=FirstRow;
+		SLOG(SNTC, "Window: rows %lld to %lld of %lld", FirstRow, EndRow, ExpectRows);
+		ExpectRows=EndRow-FirstRow;
+	}
+
+	N2data->DataPathname=N2strdup(N2data, PathName);
+	if (N2data->DataPathname==NULL) { SLOG(SERR, "Out of memory"); close(fd); return -(errno=ENOMEM); }
+
+	// Print presentation header
+	//	printf("%s", N2data->Labels[0]);
+	char Buf[1024*1024]="RelTime (s)";	// WARNING: default java stack size is very small, only 320Kb !!! Use -Xss4m
+	if (SetRelTimeColumn(N2data)<0) { close(fd); return -errno; }
+	
+	// Skip this block if not in debug mode
+	int ShowDebug=SimpleLog_FilterLevel(-1)&SL_DEBUG;
+	if (ShowDebug) {
+		for (int i=1; i<N2data->NbCol; i++) sprintf(Buf+strlen(Buf), ", %s", N2data->Labels[i]);
+		SLOG(SDBG, "%s", Buf);
+	}
+		 
+	if (AllocRows(N2data, ExpectRows)<0) { close(fd); return -errno; }
+	
+	// Read big chunks of whole records and de-interleave them, instead of 3 freads per row.
+	// Optionally split the file in row-aligned ranges, each decoded by its own thread straight into place
+	int BlockRows=N2_BLOCK_SIZE/RecSize;
+	if (BlockRows<1) BlockRows=1;
+	int NbThreads=(ShowDebug ? 1 : N2data->NbThreads);
+	if (NbThreads>ExpectRows/BlockRows) NbThreads=ExpectRows/BlockRows;	// At least one block each
+	if (NbThreads<1) NbThreads=1;
+	
+	tReadJob *Jobs=calloc(NbThreads, sizeof(tReadJob));
+	if (Jobs==NULL) { close(fd); return -(errno=ENOMEM); }
+	for (int t=0; t<NbThreads; t++) {
+		long long Start=ExpectRows*t/NbThreads, End=ExpectRows*(t+1)/NbThreads;
+		Jobs[t]=(tReadJob){ .N2data=N2data, .fd=fd, .RecSize=RecSize, .BlockRows=BlockRows, 
+							.FileRow=FirstRow+Start, .Dest=Start, .NbRows=End-Start,
+							.RefTimeStamp=(AltFirstTimeStamp==0?N2data->FirstTimeStamp:AltFirstTimeStamp),
+							.DebugBuf=(ShowDebug ? Buf : NULL) };
+	}
+	if (NbThreads==1) ReadRange(&Jobs[0]);
+	else {
+		SLOG(SNTC, "Reading with %d threads", NbThreads);
+		pthread_t Threads[NbThreads];
+		for (int t=0; t<NbThreads; t++) 
+			if (pthread_create(&Threads[t], NULL, ReadRange, &Jobs[t])) { ReadRange(&Jobs[t]); Jobs[t].fd=-1; }	// Do it ourselves
+		for (int t=0; t<NbThreads; t++) 
+			if (Jobs[t].fd>=0) pthread_join(Threads[t], NULL);
+	}
+	close(fd); fd=-1;
+	
+	// The rows are valid up to the 1st incomplete range
+	int NbBad=0, Err=0;
+	N2data->NbRow=0;
+	for (int t=0; t<NbThreads; t++) {
+		NbBad+=Jobs[t].NbBad;
+		if (Err==0) Err=Jobs[t].Err;
+		if (N2data->NbRow==Jobs[t].Dest) N2data->NbRow+=Jobs[t].NbRead;
+	}
+	if (!N2data->Columnar and !N2data->UseArena)	// So that nothing is lost after a hole
+		for (long long i=N2data->NbRow; i<ExpectRows; i++) 
+			if (N2data->Data[i]) { free(N2data->Data[i]); N2data->Data[i]=NULL; __sync_fetch_and_add(&NbFree, 1); }
+	free(Jobs);
+	if (NbBad) SLOG(SERR, "%d wrong EOL markers (expecting 0x%llX)", NbBad, N2data->EOLidentifier);
+	
+	N2data->ReservedSize=N2data->NbRow;
+	
+	if (N2data->NbRow!=ExpectRows) 
+		 SLOG(SERR, "Row number discrepancy: %lld!=%lld", N2data->NbRow, ExpectRows);
+	else SLOG(SNTC, "NbRow=%lld", N2data->NbRow);
+	
+	errno=Err;
+	if (errno) SLOG(SERR, "Error on data file %s: %s", PathName, strerror(errno));
 	return errno ? -errno : N2data->NbRow;
 }
 
@@ -507,21 +1864,21 @@ static long long GetMissingLastTimeStamp(const char* DataPathName, int NbCols) {
 	SLOG(SDBG, "Enter: %s", DataPathName);
 	
 	errno=0;
-	FILE* fd=fopen(DataPathName, "rb");
-	if (fd==NULL) {
+	int fd=open(DataPathName, O_RDONLY);
+	if (fd<0) {
 		SLOG(SERR, "Could not open data file %s: %s", DataPathName, strerror(errno));
 		return 0;	//-errno;
 	}
 	
-	int RowSize=(NbCols+1)*sizeof(double);	// Includes Reltime and EOF marker
-	//	int ExpectRows=Size/RowSize;
-	fseek(fd, -RowSize, SEEK_END);	// Position on last row
-	
+	off_t RowSize=(NbCols+1)*sizeof(double);	// Includes Reltime and EOF marker
+	struct stat st;
 	long long TimeStamp=0;
-	int R=fread(&TimeStamp,   sizeof(long long), 1, fd);
-	if (R!=1) SLOG(SERR, "%s: %s", strerror(errno), DataPathName);
-	fclose(fd);
-	return R==1 ? TimeStamp : 0;	//-errno;
+	int R=0;
+	if (fstat(fd, &st)==0 and st.st_size>=RowSize)	// Position on last row, 64 bits
+		R=(sizeof(TimeStamp)==pread(fd, &TimeStamp, sizeof(TimeStamp), (st.st_size/RowSize-1)*RowSize));
+	if (!R) SLOG(SERR, "%s: %s", strerror(errno), DataPathName);
+	close(fd);
+	return R ? TimeStamp : 0;	//-errno;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -541,76 +1898,1149 @@ static const char* ConfigToDataName(const char* ConfigPathName) {
 /// HIPAR	ConfigOnly / 1: does not read associated data
 /// HIRET	<0 is error, or number of rows read
 ///////////////////////////////////////////////////////////////////////////////
-int N2_ReadFile(const char* ConfigPathName, tN2data *N2data) {
+long long N2_ReadFile(const char* ConfigPathName, tN2data *N2data) {
 	SLOG(SDBG, "Enter");
 	int R=N2_ReadConfig(ConfigPathName, N2data , 1);
 	if (R<0) return R;
-	return ReadData(ConfigToDataName(ConfigPathName), N2data, 0);
+	return ReadData(ConfigToDataName(ConfigPathName), N2data, 0, 0, 0);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
-/// HIFN	Returns a config or data pathname based on parameter
+/// HIFN	Read the config and only the listed columns of the associated data
+/// HIPAR	ColList / Comma separated list of column names or indices, ex: "ADC1,ADC2" or "1,2,7"
+/// HIPAR	ColList / The timestamp is always kept as column 0, other columns are in the order of the list
+/// HIRET	<0 is error, or number of rows read
 ///////////////////////////////////////////////////////////////////////////////
-const char* N2_MakePathName(int IsConfig, const char* RootDirName, int Direct, int RunNo, int CycNo, int SizeIdx, const char* Subsystem, int HdrVer) {
-	/*thread_local*/ static __thread char Str[PATH_MAX];
-	if (IsConfig)
-		if (Direct) sprintf(Str, "%s"        "/%06d_%06d_%03d_%s_%03d.hd", RootDirName,                         RunNo, CycNo, SizeIdx, Subsystem, HdrVer);
-		else        sprintf(Str, "%s/%03d/%03d/%06d_%06d_%03d_%s_%03d.hd", RootDirName, RunNo/1000, RunNo%1000, RunNo, CycNo, SizeIdx, Subsystem, HdrVer);
-	else
-		if (Direct) sprintf(Str, "%s"        "/%06d_%06d_%03d_%s.EDMdat",  RootDirName,                         RunNo, CycNo, SizeIdx, Subsystem);
-		else        sprintf(Str, "%s/%03d/%03d/%06d_%06d_%03d_%s.EDMdat",  RootDirName, RunNo/1000, RunNo%1000, RunNo, CycNo, SizeIdx, Subsystem);
-	return Str;
+long long N2_ReadFileCols(const char* ConfigPathName, tN2data *N2data, const char* ColList) {
+	SLOG(SDBG, "Enter %s", ColList);
+	int R=N2_ReadConfig(ConfigPathName, N2data , 1);
+	if (R<0) return R;
+	if (ColList!=NULL and (R=ProjectColumns(N2data, ColList))<0) return R;
+	return ReadData(ConfigToDataName(ConfigPathName), N2data, 0, 0, 0);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
-/// HIFN	Read the header AND data associated with given parameters
-/// HIPAR	Direct / 0: read file in dir, 1:the DirName is partly based on RunNo as well: RootDirName/RunNo/RunNo_CycNo_SizeIdx_Subsystem_HdrVer.hd
+/// HIFN	Read the config and only the part of the data within a time window
+/// HIPAR	ColList / Optional list of columns, see N2_ReadFileCols(). NULL for all
+/// HIPAR	TimeStampLow / Only read rows with TimeStampLow<=TimeStamp<=TimeStampHigh. 0 for no limit
+/// HIPAR	TimeStampLow / Absolute timestamps (ns since 1970), see N2_ReadFileRelWindow() for times from the start of the cycle
+/// HIPAR	TimeStampLow / The first and last rows are found by binary search, so this costs a few reads
+/// HIRET	<0 is error, or number of rows read
 ///////////////////////////////////////////////////////////////////////////////
-int N2_ReadData(const char* RootDirName, int Direct, 
-				int RunNo, int CycNo, int SizeIdx, const char* Subsystem, int HdrVer, 
-				tN2data *N2data, long long AltFirstTimeStamp) {
-	SLOG(SDBG, "Enter");
-	int R=N2_ReadConfig(N2_MakePathName(1, RootDirName, Direct, RunNo, CycNo, SizeIdx, Subsystem, HdrVer), N2data, 1);
-	return R<0 ? R :
-			ReadData(   N2_MakePathName(0, RootDirName, Direct, RunNo, CycNo, SizeIdx, Subsystem, 0     ), N2data, AltFirstTimeStamp);
+long long N2_ReadFileWindow(const char* ConfigPathName, tN2data *N2data, const char* ColList, 
+					  long long TimeStampLow, long long TimeStampHigh) {
+	SLOG(SDBG, "Enter %lld~%lld", TimeStampLow, TimeStampHigh);
+	int R=N2_ReadConfig(ConfigPathName, N2data , 1);
+	if (R<0) return R;
+	if (ColList!=NULL and (R=ProjectColumns(N2data, ColList))<0) return R;
+	return ReadData(ConfigToDataName(ConfigPathName), N2data, 0, TimeStampLow, TimeStampHigh);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
-/// Glue code. See SimpleLog.c for sytax
+/// HIFN	Same as N2_ReadFileWindow(), but the window is in seconds from the FirstTimeStamp of the header,
+/// HIFN	the same reference as the RelTime of column 0. The header is read only once
+/// HIPAR	StartSec / Only read rows with StartSec<=RelTime<=StopSec
+/// HIPAR	StopSec / <0 to read until the end
+/// HIRET	<0 is error, or number of rows read
 ///////////////////////////////////////////////////////////////////////////////
-void N2_LogSetup(const char *PathName, 
-					const char *TimeFormat, 
-					const int NoRepeatLastN, 
-					const int RepeatMaxCount,
-					const int RepeatMaxSeconds,
-					const char *Separator) {
-	SimpleLog_Setup(PathName, TimeFormat, NoRepeatLastN, RepeatMaxCount, RepeatMaxSeconds, Separator);
-}
-
-int N2_LogFilterLevel(const int LogLevel) {
-	return SimpleLog_FilterLevel(LogLevel);
+long long N2_ReadFileRelWindow(const char* ConfigPathName, tN2data *N2data, const char* ColList, 
+							   double StartSec, double StopSec) {
+	SLOG(SDBG, "Enter %.3f~%.3fs", StartSec, StopSec);
+	int R=N2_ReadConfig(ConfigPathName, N2data , 1);
+	if (R<0) return R;
+	if (ColList!=NULL and (R=ProjectColumns(N2data, ColList))<0) return R;
+	long long Low =N2data->FirstTimeStamp+llround(StartSec*1e9);
+	long long High=(StopSec<0 ? 0 : N2data->FirstTimeStamp+llround(StopSec*1e9));
+	if (Low==0) Low=1;	// 0 would mean no limit
+	return ReadData(ConfigToDataName(ConfigPathName), N2data, 0, Low, High);
 }
 
-
-
 ///////////////////////////////////////////////////////////////////////////////
-// And now for the features to find the data files
+/// HIFN	Read the config and map the associated data file read-only, without copying anything
+/// HIFN	The mapping is shared with any other process looking at the same file through the page cache
+/// HIPAR	ConfigPathName / Name of the config file (.hd). The name of the data file is derived from there
+/// HIPAR	N2data / Filled with the config only: TimeStamp/Data stay empty
+/// HIPAR	View / Use N2_View*() to access it, and N2_UnmapFile() when done
+/// HIRET	<0 is error, or number of rows
 ///////////////////////////////////////////////////////////////////////////////
+long long N2_MapFile(const char* ConfigPathName, tN2data *N2data, tN2view *View) {
+	SLOG(SDBG, "Enter");
+	bzero(View, sizeof(tN2view));
+	int R=N2_ReadConfig(ConfigPathName, N2data, 1);
+	if (R<0) return R;
+	const char* PathName=ConfigToDataName(ConfigPathName);
 
-#include <dirent.h>	// For directory-related stuff on Linux
-//#include <config.h>
-//#include <gl_oset.h>
-
-#define DEF_ALLOC 1000000		// NOTE: Should be 10^6 for number of possible Cycle numbers
+	errno=0;
+	int fd=open(PathName, O_RDONLY);
+	if (fd<0) {
+		SLOG(SERR, "Could not open data file %s: %s", PathName, strerror(errno));
+		return -errno;
+	}
+	struct stat st;
+	if (fstat(fd, &st)) { R=-errno; close(fd); return R; }
+	
+	View->NbCol =FILE_NBCOL(N2data);
+	View->Stride=View->NbCol+1;
+	View->NbRow =st.st_size/(View->Stride*8);
+	if (View->NbRow>0) {
+		View->Size=st.st_size;
+		void *P=mmap(NULL, View->Size, PROT_READ, MAP_SHARED, fd, 0);
+		if (P==MAP_FAILED) {
+			R=-errno; close(fd);
+			SLOG(SERR, "Could not map data file %s: %s", PathName, strerror(-R));
+			bzero(View, sizeof(tN2view));
+			return R;
+		}
+		View->Base=P;
+	}
+	close(fd);	// The mapping stays valid
+	
+	N2data->DataPathname=N2strdup(N2data, PathName);
+	if (N2data->DataPathname==NULL) { N2_UnmapFile(View); SLOG(SERR, "Out of memory"); return -(errno=ENOMEM); }
+	SLOG(SNTC, "Mapped %lld rows of %s", View->NbRow, PathName);
+	return View->NbRow;
+}
 
-static int CompareInt(const void *A, const void *B) { 
-	return *(int*)A-*(int*)B; 
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	Release a view obtained with N2_MapFile()
+///////////////////////////////////////////////////////////////////////////////
+void N2_UnmapFile(tN2view *View) {
+	if (View==NULL) return;
+	if (View->Base) munmap((void*)View->Base, View->Size);
+	bzero(View, sizeof(tN2view));
 }
 
 ///////////////////////////////////////////////////////////////////////////////
-// WARNING: A and B are not equivalent. You figure it out...
+/// HIFN	Open a data file to read it by fixed-size chunks of rows, with a constant memory footprint
+/// HIPAR	Stream / Stream->N2data receives the config, then each chunk in turn. It is always columnar
+/// HIPAR	ColList / Optional list of columns, see N2_ReadFileCols(). NULL for all
+/// HIPAR	ChunkRows / Number of rows per chunk, or 0 for a default of a few MB
+/// HIRET	<0 is error, or total number of rows in the file
 ///////////////////////////////////////////////////////////////////////////////
-static int CompareStr(const void *A, const void *B) { 
+long long N2_OpenStream(const char* ConfigPathName, tN2stream *Stream, const char* ColList, int ChunkRows) {
+	SLOG(SDBG, "Enter");
+	bzero(Stream, sizeof(tN2stream));
+	Stream->fd=-1;
+	Stream->N2data.Columnar=1;
+	int R=N2_ReadConfig(ConfigPathName, &Stream->N2data, 1);
+	if (R<0) return R;
+	if (ColList!=NULL and (R=ProjectColumns(&Stream->N2data, ColList))<0) goto Error;
+	if ((R=SetRelTimeColumn(&Stream->N2data))<0) goto Error;
+	
+	tN2data *N2data=&Stream->N2data;
+	const char* PathName=ConfigToDataName(ConfigPathName);
+	errno=0;
+	if ((Stream->fd=open(PathName, O_RDONLY))<0) {
+		R=-errno;
+		SLOG(SERR, "Could not open data file %s: %s", PathName, strerror(errno));
+		goto Error;
+	}
+	struct stat st;
+	if (fstat(Stream->fd, &st)) { R=-errno; goto Error; }
+	Stream->RecSize=(FILE_NBCOL(N2data)+1)*8;
+	Stream->NbRowTotal=st.st_size/Stream->RecSize;
+	Stream->ChunkRows=(ChunkRows>0 ? ChunkRows : N2_BLOCK_SIZE/Stream->RecSize);
+	if ((size_t)Stream->ChunkRows>(size_t)SSIZE_MAX/Stream->RecSize) Stream->ChunkRows=(size_t)SSIZE_MAX/Stream->RecSize;	// A chunk must fit in one pread()
+	if (Stream->ChunkRows<1) Stream->ChunkRows=1;
+	
+	N2data->DataPathname=N2strdup(N2data, PathName);
+	Stream->Block=AlignedAlloc((size_t)Stream->ChunkRows*Stream->RecSize);
+	if (N2data->DataPathname==NULL or Stream->Block==NULL or ReserveRows(N2data, Stream->ChunkRows)<0) { R=-(errno=ENOMEM); goto Error; }
+	SLOG(SNTC, "%lld rows by chunks of %d", Stream->NbRowTotal, Stream->ChunkRows);
+	return Stream->NbRowTotal;
+
+Error:
+	N2_CloseStream(Stream);
+	return R;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	Read the next chunk of rows into Stream->N2data, overwriting the previous one
+/// HIFN	Stream->Row is the index in the file of the first row of the chunk
+/// HIRET	<0 is error, 0 at the end, or number of rows in the chunk (Stream->N2data.NbRow)
+///////////////////////////////////////////////////////////////////////////////
+int N2_NextChunk(tN2stream *Stream) {
+	tN2data *N2data=&Stream->N2data;
+	Stream->Row+=N2data->NbRow;
+	N2data->NbRow=0;
+	if (Stream->fd<0 or Stream->Row>=Stream->NbRowTotal) return 0;
+	
+	int Want=(Stream->NbRowTotal-Stream->Row<Stream->ChunkRows ? (int)(Stream->NbRowTotal-Stream->Row) : Stream->ChunkRows);
+	ssize_t Got=pread(Stream->fd, Stream->Block, (size_t)Want*Stream->RecSize, (off_t)Stream->Row*Stream->RecSize);
+	if (Got<0) { SLOG(SERR, "Error on data file %s: %s", N2data->DataPathname, strerror(errno)); return -errno; }
+	Want=Got/Stream->RecSize;	// Short read: whole records only
+	if (Want==0) { SLOG(SWRN, "Unexpected end of file %s", N2data->DataPathname); return 0; }
+	
+	int R=DecodeBlock(N2data, Stream->Block, Want, 0, N2data->FirstTimeStamp);
+	if (R<0) return R;
+	if (R>0) SLOG(SERR, "%d wrong EOL markers (expecting 0x%llX)", R, N2data->EOLidentifier);
+	return N2data->NbRow=Want;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	Close the file and free everything opened by N2_OpenStream()
+///////////////////////////////////////////////////////////////////////////////
+void N2_CloseStream(tN2stream *Stream) {
+	if (Stream==NULL) return;
+	if (Stream->fd>=0) close(Stream->fd);
+	if (Stream->Block) free(Stream->Block);
+	N2_ClearConfig(&Stream->N2data);
+	bzero(Stream, sizeof(tN2stream));
+	Stream->fd=-1;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	Follow a data file while it is being written: each N2_PollFollow() reads only the new records
+/// HIPAR	Follow / Follow->N2data receives the config, then the rows. It is always columnar
+/// HIPAR	ColList / Optional list of columns, see N2_ReadFileCols(). NULL for all
+/// HIPAR	ConfigPathName / The data file doesn't need to exist yet. If the header has no firstTimeStamp, 
+/// HIPAR	ConfigPathName / the relative times start from the first record read
+/// HIRET	<0 is error, or 0
+///////////////////////////////////////////////////////////////////////////////
+int N2_OpenFollow(const char* ConfigPathName, tN2follow *Follow, const char* ColList) {
+	SLOG(SDBG, "Enter");
+	bzero(Follow, sizeof(tN2follow));
+	Follow->fd=-1;
+	Follow->N2data.Columnar=1;
+	int R=N2_ReadConfig(ConfigPathName, &Follow->N2data, 2);
+	if (R<0) return R;
+	if (ColList!=NULL and (R=ProjectColumns(&Follow->N2data, ColList))<0) goto Error;
+	if ((R=SetRelTimeColumn(&Follow->N2data))<0) goto Error;
+	
+	tN2data *N2data=&Follow->N2data;
+	Follow->RecSize=(FILE_NBCOL(N2data)+1)*8;
+	Follow->BlockRows=N2_BLOCK_SIZE/Follow->RecSize;
+	if (Follow->BlockRows<1) Follow->BlockRows=1;
+	N2data->DataPathname=N2strdup(N2data, ConfigToDataName(ConfigPathName));
+	Follow->Block=AlignedAlloc((size_t)Follow->BlockRows*Follow->RecSize);
+	if (N2data->DataPathname==NULL or Follow->Block==NULL) { R=-(errno=ENOMEM); goto Error; }
+	return 0;
+
+Error:
+	N2_CloseFollow(Follow);
+	return R;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	Same as N2_PollFollow()
+/// HIPAR	Final / 1 if the writer is done: the whole records at the end are read even with a wrong EOL
+///////////////////////////////////////////////////////////////////////////////
+static long long PollFollow(tN2follow *Follow, int KeepOld, int Final) {
+	tN2data *N2data=&Follow->N2data;
+	if (!KeepOld) { Follow->Row+=N2data->NbRow; N2data->NbRow=0; }
+	if (Follow->fd<0 and (Follow->fd=open(N2data->DataPathname, O_RDONLY))<0) {
+		if (errno==ENOENT) return 0;	// Not created yet
+		SLOG(SERR, "Could not open data file %s: %s", N2data->DataPathname, strerror(errno));
+		return -errno;
+	}
+	
+	struct stat st;
+	if (fstat(Follow->fd, &st)) { SLOG(SERR, "Cannot stat %s: %s", N2data->DataPathname, strerror(errno)); return -errno; }
+	long long Avail=st.st_size/Follow->RecSize-Follow->NbRowTotal;
+	if (Avail<0) {
+		SLOG(SERR, "%s was truncated to %lld rows, %lld already read", N2data->DataPathname, 
+			 (long long)st.st_size/Follow->RecSize, Follow->NbRowTotal);
+		return -(errno=ESTALE);
+	}
+	if (Avail==0) return 0;
+	
+	long long NewSize=2*N2data->ReservedSize;	// Geometric growth, as in N2_AddDataWithFilter()
+	if (NewSize<N2data->NbRow+Avail) NewSize=N2data->NbRow+Avail;
+	if (N2data->ReservedSize<N2data->NbRow+Avail and ReserveRows(N2data, NewSize)<0) return -errno;
+	
+	const int W=FILE_NBCOL(N2data)+1;
+	long long NbNew=0;
+	while (NbNew<Avail) {
+		int Want=(Avail-NbNew<Follow->BlockRows ? (int)(Avail-NbNew) : Follow->BlockRows);
+		ssize_t Got=pread(Follow->fd, Follow->Block, (size_t)Want*Follow->RecSize, (off_t)Follow->NbRowTotal*Follow->RecSize);
+		if (Got<0) { SLOG(SERR, "Error on data file %s: %s", N2data->DataPathname, strerror(errno)); return -errno; }
+		int NbRec=Got/Follow->RecSize, Last=(NbNew+NbRec==Avail);
+		if (Last and !Final)	// The writer may not be done with the last records
+			while (NbRec>0 and (unsigned long long)Follow->Block[(long long)NbRec*W-1]!=N2data->EOLidentifier) NbRec--;
+		if (NbRec==0) break;
+		if (N2data->FirstTimeStamp==0) N2data->FirstTimeStamp=Follow->Block[0];	// Not in the header, the 1st record is the reference
+		
+		int R=DecodeBlock(N2data, Follow->Block, NbRec, N2data->NbRow, N2data->FirstTimeStamp);
+		if (R<0) return R;
+		if (R>0) SLOG(SERR, "%d wrong EOL markers (expecting 0x%llX)", R, N2data->EOLidentifier);
+		N2data->NbRow+=NbRec;
+		Follow->NbRowTotal+=NbRec;
+		NbNew+=NbRec;
+		if (Last or NbRec<Want) break;
+	}
+	SLOG(SDBG, "%lld new rows in %s", NbNew, N2data->DataPathname);
+	return NbNew;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	Read the whole records appended to the file since the last call
+/// HIFN	A partial record at the end, or whole records at the end whose EOL isn't written yet, 
+/// HIFN	are left for the next call. Wrong EOL markers followed by good records are reported as usual
+/// HIPAR	KeepOld / 1: the new rows are appended to Follow->N2data, 0: they replace the previous ones
+/// HIPAR	KeepOld / (then Follow->Row is the index in the file of the first row of Follow->N2data)
+/// HIRET	<0 is error, or number of new rows (0 if nothing new)
+///////////////////////////////////////////////////////////////////////////////
+long long N2_PollFollow(tN2follow *Follow, int KeepOld) {
+	return PollFollow(Follow, KeepOld, 0);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	Last poll once the writer is done (file closed), before N2_CloseFollow(): 
+/// HIFN	the whole records at the end are read too, a wrong EOL marker is reported instead of waited for
+/// HIRET	<0 is error, or number of new rows
+///////////////////////////////////////////////////////////////////////////////
+long long N2_FlushFollow(tN2follow *Follow, int KeepOld) {
+	return PollFollow(Follow, KeepOld, 1);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	Close the file and free everything opened by N2_OpenFollow()
+///////////////////////////////////////////////////////////////////////////////
+void N2_CloseFollow(tN2follow *Follow) {
+	if (Follow==NULL) return;
+	if (Follow->fd>=0) close(Follow->fd);
+	if (Follow->Block) free(Follow->Block);
+	N2_ClearConfig(&Follow->N2data);
+	bzero(Follow, sizeof(tN2follow));
+	Follow->fd=-1;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	Returns a config or data pathname based on parameter
+///////////////////////////////////////////////////////////////////////////////
+const char* N2_MakePathName(int IsConfig, const char* RootDirName, int Direct, int RunNo, int CycNo, int SizeIdx, const char* Subsystem, int HdrVer) {
+	/*thread_local*/ static __thread char Str[PATH_MAX];
+	if (IsConfig)
+		if (Direct) sprintf(Str, "%s"        "/%06d_%06d_%03d_%s_%03d.hd", RootDirName,                         RunNo, CycNo, SizeIdx, Subsystem, HdrVer);
+		else        sprintf(Str, "%s/%03d/%03d/%06d_%06d_%03d_%s_%03d.hd", RootDirName, RunNo/1000, RunNo%1000, RunNo, CycNo, SizeIdx, Subsystem, HdrVer);
+	else
+		if (Direct) sprintf(Str, "%s"        "/%06d_%06d_%03d_%s.EDMdat",  RootDirName,                         RunNo, CycNo, SizeIdx, Subsystem);
+		else        sprintf(Str, "%s/%03d/%03d/%06d_%06d_%03d_%s.EDMdat",  RootDirName, RunNo/1000, RunNo%1000, RunNo, CycNo, SizeIdx, Subsystem);
+	return Str;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	Read the header AND data associated with given parameters
+/// HIPAR	Direct / 0: read file in dir, 1:the DirName is partly based on RunNo as well: RootDirName/RunNo/RunNo_CycNo_SizeIdx_Subsystem_HdrVer.hd
+///////////////////////////////////////////////////////////////////////////////
+long long N2_ReadData(const char* RootDirName, int Direct, 
+				int RunNo, int CycNo, int SizeIdx, const char* Subsystem, int HdrVer, 
+				tN2data *N2data, long long AltFirstTimeStamp) {
+	SLOG(SDBG, "Enter");
+	long long R=N2_ReadConfig(N2_MakePathName(1, RootDirName, Direct, RunNo, CycNo, SizeIdx, Subsystem, HdrVer), N2data, 1);
+	return R<0 ? R :
+			ReadData(   N2_MakePathName(0, RootDirName, Direct, RunNo, CycNo, SizeIdx, Subsystem, 0     ), N2data, AltFirstTimeStamp, 0, 0);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	One cycle of a run being loaded by N2_ReadRun()
+///////////////////////////////////////////////////////////////////////////////
+typedef struct sRunCycle {
+	int CycNo, SizeIdx;			// One part of a cycle
+	int NbCol;					// Of the data file, to check it matches the 1st cycle
+	long long EOLidentifier, LastTimeStamp;
+	long long NbRows;			// Expected from the file size
+	long long Dest;				// Where it goes in the destination
+	long long NbRead;			// Out: number of rows actually decoded
+	int NbBad, Err;				// Out: wrong EOL markers, errno
+} tRunCycle;
+
+typedef struct sRunLoad {
+	const char *RootDirName, *Subsystem;
+	int Direct, RunNo;
+	tN2data *N2data;			// Destination, header of the 1st cycle
+	tRunCycle *Cyc;
+	int NbCyc, Next, Pass;		// Next is the next cycle to be taken by a thread
+	long long RefTimeStamp;		// Relative time zero for all cycles
+} tRunLoad;
+
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	Thread function for N2_ReadRun(), Arg is a tRunLoad
+/// HIFN	Pass 0: read the headers and sizes. Pass 1: read each data file straight into its place
+///////////////////////////////////////////////////////////////////////////////
+static void* LoadCycles(void* Arg) {
+	tRunLoad *L=Arg;
+	tN2data Hdr={0};
+	for (int i; (i=__sync_fetch_and_add(&L->Next, 1))<L->NbCyc; ) {
+		tRunCycle *C=&L->Cyc[i];
+		if (L->Pass==0) {
+			int R=N2_ReadConfig(N2_MakePathName(1, L->RootDirName, L->Direct, L->RunNo, C->CycNo, C->SizeIdx, L->Subsystem, 0), &Hdr, 1);
+			if (R<0) { C->Err=-R; continue; }
+			C->NbCol=Hdr.NbCol;
+			C->EOLidentifier=Hdr.EOLidentifier;
+			C->LastTimeStamp=Hdr.LastTimeStamp;
+			struct stat st;
+			if (stat(N2_MakePathName(0, L->RootDirName, L->Direct, L->RunNo, C->CycNo, C->SizeIdx, L->Subsystem, 0), &st)) { C->Err=errno; continue; }
+			C->NbRows=st.st_size/((C->NbCol+1)*8);
+			continue;
+		}
+		
+		if (C->Err or C->NbRows==0) continue;
+		const char* PathName=N2_MakePathName(0, L->RootDirName, L->Direct, L->RunNo, C->CycNo, C->SizeIdx, L->Subsystem, 0);
+		int fd=open(PathName, O_RDONLY);
+		if (fd<0) { C->Err=errno; SLOG(SERR, "Could not open data file %s: %s", PathName, strerror(errno)); continue; }
+		tN2data Dest=*L->N2data;	// Shares the arrays, but this cycle may have its own EOL marker
+		Dest.EOLidentifier=C->EOLidentifier;
+		int BlockRows=N2_BLOCK_SIZE/((C->NbCol+1)*8);
+		tReadJob Job={ .N2data=&Dest, .fd=fd, .RecSize=(C->NbCol+1)*8, .BlockRows=(BlockRows<1 ? 1 : BlockRows), 
+					   .FileRow=0, .Dest=C->Dest, .NbRows=C->NbRows, .RefTimeStamp=L->RefTimeStamp };
+		ReadRange(&Job);
+		close(fd);
+		C->NbRead=Job.NbRead; C->NbBad=Job.NbBad; C->Err=Job.Err;
+	}
+	N2_ClearConfig(&Hdr);
+	return NULL;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	Run LoadCycles() on NbThreads threads
+///////////////////////////////////////////////////////////////////////////////
+static void LoadCyclesParallel(tRunLoad *L, int Pass, int NbThreads) {
+	L->Pass=Pass; L->Next=0;
+	if (NbThreads>L->NbCyc) NbThreads=L->NbCyc;
+	if (NbThreads<=1) { LoadCycles(L); return; }
+	pthread_t Threads[NbThreads];
+	int Started=0;
+	for (; Started<NbThreads; Started++) 
+		if (pthread_create(&Threads[Started], NULL, LoadCycles, L)) break;
+	LoadCycles(L);	// Help, or do it all if no thread could be created
+	for (int t=0; t<Started; t++) pthread_join(Threads[t], NULL);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	Read all the cycles of a run for one subsystem into a single tN2data, with all the SizeIdx parts of each cycle
+/// HIFN	The headers are read first to size the destination once, then the parts are read in parallel,
+/// HIFN	each straight to its final place. Relative time (column 0) is from the start of the 1st cycle
+/// HIPAR	ColList / Optional list of columns, see N2_ReadFileCols(). NULL for all
+/// HIPAR	N2data / Set N2data->NbThreads to limit the number of threads, 0 to use all the cores
+/// HIPAR	N2data / Parts whose number of columns differs from the 1st one are skipped
+/// HIRET	-errno or total number of rows
+///////////////////////////////////////////////////////////////////////////////
+long long N2_ReadRun(const char* RootDirName, int Direct, int RunNo, const char* Subsystem, 
+					 tN2data *N2data, const char* ColList) {
+	SLOG(SDBG, "Enter: run %d, %s", RunNo, Subsystem);
+	int *Parts=NULL;
+	int NC=GetRunParts(RootDirName, Direct, RunNo, Subsystem, &Parts);
+	if (NC<=0) { free(Parts); N2_ClearConfig(N2data); return NC<0 ? NC : -(errno=ENOENT); }
+	
+	long long R=N2_ReadConfig(N2_MakePathName(1, RootDirName, Direct, RunNo, Parts[0]/1000, Parts[0]%1000, Subsystem, 0), N2data, 1);
+	tRunLoad L={ .RootDirName=RootDirName, .Subsystem=Subsystem, .Direct=Direct, .RunNo=RunNo, 
+				 .N2data=N2data, .NbCyc=NC, .RefTimeStamp=N2data->FirstTimeStamp, 
+				 .Cyc=calloc(NC, sizeof(tRunCycle)) };
+	if (R>=0 and L.Cyc==NULL) R=-(errno=ENOMEM);
+	if (R>=0 and ColList!=NULL) R=ProjectColumns(N2data, ColList);
+	if (R>=0) R=SetRelTimeColumn(N2data);
+	if (R<0) goto End;
+	N2data->DataPathname=N2strdup(N2data, N2_MakePathName(0, RootDirName, Direct, RunNo, Parts[0]/1000, Parts[0]%1000, Subsystem, 0));
+	
+	int NbThreads=(N2data->NbThreads>0 ? N2data->NbThreads : (int)sysconf(_SC_NPROCESSORS_ONLN));
+	for (int i=0; i<NC; i++) { L.Cyc[i].CycNo=Parts[i]/1000; L.Cyc[i].SizeIdx=Parts[i]%1000; }
+	LoadCyclesParallel(&L, 0, NbThreads);
+	
+	long long Total=0;
+	for (int i=0; i<NC; i++) {
+		tRunCycle *C=&L.Cyc[i];
+		if (C->Err) SLOG(SWRN, "Skipping cycle %d part %d: %s", C->CycNo, C->SizeIdx, strerror(C->Err));
+		else if (C->NbCol!=FILE_NBCOL(N2data)) {
+			SLOG(SWRN, "Skipping cycle %d part %d: %d columns instead of %d", C->CycNo, C->SizeIdx, C->NbCol, FILE_NBCOL(N2data));
+			C->NbRows=0;
+		} else {
+			C->Dest=Total; Total+=C->NbRows;
+			if (C->NbRows>0) N2data->LastTimeStamp=C->LastTimeStamp;
+		}
+	}
+	SLOG(SNTC, "%d parts, %lld rows, %d threads", NC, Total, NbThreads);
+	if (AllocRows(N2data, Total)<0) { R=-errno; goto End; }
+	
+	LoadCyclesParallel(&L, 1, NbThreads);
+
+	// Close the gaps left by short reads, if any
+	int NbBad=0, Err=0;
+	N2data->NbRow=0;
+	for (int i=0; i<NC; i++) {
+		tRunCycle *C=&L.Cyc[i];
+		NbBad+=C->NbBad;
+		if (C->Err and Err==0) Err=C->Err;
+		if (C->Dest!=N2data->NbRow and C->NbRead>0) {
+			memmove(N2data->TimeStamp+N2data->NbRow, N2data->TimeStamp+C->Dest, C->NbRead*sizeof(long long));
+			if (N2data->Columnar)
+				for (int c=0; c<N2data->NbCol; c++) 
+					memmove((long long*)N2data->Cols[c]+N2data->NbRow, (long long*)N2data->Cols[c]+C->Dest, C->NbRead*8);
+			else for (long long r=0; r<C->NbRead; r++) {
+				void *Row=N2data->Data[N2data->NbRow+r];	// Swap, so that the leftovers can still be freed
+				N2data->Data[N2data->NbRow+r]=N2data->Data[C->Dest+r];
+				N2data->Data[C->Dest+r]=Row;
+			}
+		}
+		N2data->NbRow+=C->NbRead;
+	}
+	if (!N2data->Columnar and !N2data->UseArena)
+		for (long long i=N2data->NbRow; i<Total; i++) 
+			if (N2data->Data[i]) { free(N2data->Data[i]); N2data->Data[i]=NULL; __sync_fetch_and_add(&NbFree, 1); }
+	N2data->ReservedSize=Total;
+	if (NbBad) SLOG(SERR, "%d wrong EOL markers", NbBad);
+	if (N2data->NbRow!=Total) SLOG(SERR, "Row number discrepancy: %lld!=%lld", N2data->NbRow, Total);
+	R=N2data->NbRow;
+	if (Err) SLOG(SWRN, "Some cycles could not be read: %s", strerror(Err));
+
+End:
+	free(Parts);
+	if (L.Cyc) free(L.Cyc);
+	return R;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Prefetch: I/O threads read the upcoming files while the consumer works on the current one.
+// The files go through a ring of slots, each one with a sequence number (no locks):
+// Seq==i: free for file i, Seq==i+1: file i is ready, then Seq=i+NbSlots when the consumer is done with it
+///////////////////////////////////////////////////////////////////////////////
+
+typedef struct sPrefetchSlot {
+	int Seq;
+	long long R;				// Result of the read
+	tN2data N2data;
+} tPrefetchSlot;
+
+typedef struct sPrefetchFile {	// One SizeIdx part of a cycle
+	int RunNo, CycNo, SizeIdx;
+	char *Subsystem;
+} tPrefetchFile;
+
+struct sN2prefetch {
+	char *RootDirName;
+	int Direct;
+	tPrefetchFile *Files;
+	int NbFiles, NbSlots, NbThreads;
+	int NextLoad;				// Next file to be taken by an I/O thread
+	int NextGive;				// Next file to hand to the consumer
+	int Stop;
+	tPrefetchSlot *Slots;
+	pthread_t *Threads;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	Wait until *Seq==Value, sleeping in the kernel. Periodically checks *Stop
+/// HIRET	0, or 1 if stopped
+///////////////////////////////////////////////////////////////////////////////
+static int WaitSeq(int *Seq, int Value, const int *Stop) {
+	struct timespec Timeout={0, 100*1000*1000};
+	for (int Cur; (Cur=__atomic_load_n(Seq, __ATOMIC_ACQUIRE))!=Value; ) {
+		if (Stop and __atomic_load_n(Stop, __ATOMIC_ACQUIRE)) return 1;
+		syscall(SYS_futex, Seq, FUTEX_WAIT_PRIVATE, Cur, &Timeout, NULL, 0);
+	}
+	return 0;
+}
+
+static void SetSeq(int *Seq, int Value) {
+	__atomic_store_n(Seq, Value, __ATOMIC_RELEASE);
+	syscall(SYS_futex, Seq, FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	I/O thread, Arg is a tN2prefetch
+///////////////////////////////////////////////////////////////////////////////
+static void* PrefetchFiles(void* Arg) {
+	tN2prefetch *P=Arg;
+	for (int i; (i=__sync_fetch_and_add(&P->NextLoad, 1))<P->NbFiles; ) {
+		tPrefetchSlot *S=&P->Slots[i%P->NbSlots];
+		if (WaitSeq(&S->Seq, i, &P->Stop)) break;
+		const tPrefetchFile *F=&P->Files[i];
+		S->R=N2_ReadData(P->RootDirName, P->Direct, F->RunNo, F->CycNo, F->SizeIdx, F->Subsystem, 0, &S->N2data, 0);
+		SetSeq(&S->Seq, i+1);
+	}
+	return NULL;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	Start reading a list of files in the background, Depth files ahead of the consumer
+/// HIFN	Then get them in order with N2_NextPrefetched()
+/// HIPAR	Files / List of cycles to read, copied. They all need a Subsystem
+/// HIPAR	Files / A cycle split in several SizeIdx parts gives one file per part, in order
+/// HIPAR	Files / A cycle without any header still gives one file, whose read fails
+/// HIPAR	Depth / Number of files loaded ahead, which is also the number of files in memory besides the current one
+/// HIPAR	NbIOThreads / Number of files read at the same time, at most Depth. 0 for 1
+/// HIPAR	Options / Optional. Its Columnar, UseArena and NbThreads reading options are used for all files
+/// HIRET	NULL on error (errno is set)
+///////////////////////////////////////////////////////////////////////////////
+tN2prefetch* N2_OpenPrefetch(const char* RootDirName, int Direct, const tN2fileId Files[], int NbFiles, 
+							 int Depth, int NbIOThreads, const tN2data *Options) {
+	SLOG(SDBG, "Enter: %d files, depth %d", NbFiles, Depth);
+	if (RootDirName==NULL or (Files==NULL and NbFiles>0) or NbFiles<0) { errno=EINVAL; return NULL; }
+	for (int i=0; i<NbFiles; i++)
+		if (Files[i].Subsystem==NULL) { SLOG(SERR, "No subsystem for file %d", i); errno=EINVAL; return NULL; }
+	if (Depth<1) Depth=1;
+	if (NbIOThreads<1) NbIOThreads=1;
+	if (NbIOThreads>Depth) NbIOThreads=Depth;
+	
+	tN2prefetch *P=calloc(1, sizeof(tN2prefetch));
+	if (P==NULL) { errno=ENOMEM; return NULL; }
+	P->Direct=Direct;
+	P->NbSlots=Depth+1;	// One more for the file being used by the consumer
+	P->RootDirName=strdup(RootDirName);
+	P->Slots  =calloc(P->NbSlots, sizeof(tPrefetchSlot));
+	P->Threads=calloc(NbIOThreads, sizeof(pthread_t));
+	int Err=ENOMEM;
+	if (P->RootDirName==NULL or P->Slots==NULL or P->Threads==NULL) goto Error;
+	
+	int *Parts=NULL, NbParts=0, Size=0, PartsRun=-1;	// Parts of the run of the previous cycle
+	const char *PartsSubs=NULL;
+	for (int i=0; i<NbFiles; i++) {
+		const tN2fileId *F=&Files[i];
+		if (F->RunNo!=PartsRun or strcmp(F->Subsystem, PartsSubs)) {
+			free(Parts);
+			NbParts=GetRunParts(RootDirName, Direct, F->RunNo, F->Subsystem, &Parts);
+			if (NbParts<0) NbParts=0;	// The reads will fail and say why
+			PartsRun=F->RunNo; PartsSubs=F->Subsystem;
+		}
+		int Lo=0, Hi=NbParts;	// 1st part of the cycle
+		while (Lo<Hi) { int Mid=(Lo+Hi)/2; if (Parts[Mid]<F->CycNo*1000) Lo=Mid+1; else Hi=Mid; }
+		int Nb=0;
+		for (; Lo<NbParts and Parts[Lo]/1000==F->CycNo; Lo++, Nb++) ;
+		if (P->NbFiles+(Nb ? Nb : 1)>Size) {
+			Size=2*Size+NbFiles+Nb+1;
+			tPrefetchFile *New=realloc(P->Files, Size*sizeof(tPrefetchFile));
+			if (New==NULL) { free(Parts); goto Error; }
+			P->Files=New;
+		}
+		for (int k=(Nb ? Lo-Nb : 0); k<(Nb ? Lo : 1); k++) {
+			tPrefetchFile *PF=&P->Files[P->NbFiles];
+			PF->RunNo=F->RunNo; PF->CycNo=F->CycNo; 
+			PF->SizeIdx=(Nb ? Parts[k]%1000 : 0);
+			if (NULL==(PF->Subsystem=strdup(F->Subsystem))) { free(Parts); goto Error; }
+			P->NbFiles++;
+		}
+	}
+	free(Parts);
+	SLOG(SNTC, "%d files for %d cycles", P->NbFiles, NbFiles);
+	for (int s=0; s<P->NbSlots; s++) {
+		P->Slots[s].Seq=s;
+		if (Options) {
+			P->Slots[s].N2data.Columnar =Options->Columnar;
+			P->Slots[s].N2data.UseArena =Options->UseArena;
+			P->Slots[s].N2data.NbThreads=Options->NbThreads;
+		}
+	}
+	for (; P->NbThreads<NbIOThreads; P->NbThreads++)
+		if ((Err=pthread_create(&P->Threads[P->NbThreads], NULL, PrefetchFiles, P))) break;
+	if (P->NbThreads==0) goto Error;
+	return P;
+
+Error:
+	SLOG(SERR, "Cannot start prefetching: %s", strerror(Err));
+	N2_ClosePrefetch(P);
+	errno=Err;
+	return NULL;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	Get the next file, in the order of the list, waiting for it if needed. Each SizeIdx part of a cycle is a file
+/// HIFN	It stays valid until the next call: don't clear or free it
+/// HIPAR	R / Optional, receives the result of N2_ReadData() for this file (-errno or number of rows)
+/// HIRET	NULL at the end of the list
+///////////////////////////////////////////////////////////////////////////////
+tN2data* N2_NextPrefetched(tN2prefetch *P, long long *R) {
+	if (P==NULL) return NULL;
+	int i=P->NextGive;
+	if (i>0 and i<=P->NbFiles) {	// Recycle the slot of the previous file
+		tPrefetchSlot *Prev=&P->Slots[(i-1)%P->NbSlots];
+		ClearConfig(&Prev->N2data, 1);
+		SetSeq(&Prev->Seq, i-1+P->NbSlots);
+	}
+	if (i>=P->NbFiles) return NULL;
+	P->NextGive++;
+	tPrefetchSlot *S=&P->Slots[i%P->NbSlots];
+	WaitSeq(&S->Seq, i+1, NULL);
+	if (R) *R=S->R;
+	return &S->N2data;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	Stop the I/O threads and free everything, including the file being used
+///////////////////////////////////////////////////////////////////////////////
+void N2_ClosePrefetch(tN2prefetch *P) {
+	if (P==NULL) return;
+	__atomic_store_n(&P->Stop, 1, __ATOMIC_RELEASE);
+	for (int t=0; t<P->NbThreads; t++) pthread_join(P->Threads[t], NULL);
+	if (P->Slots) 
+		for (int s=0; s<P->NbSlots; s++) N2_ClearConfig(&P->Slots[s].N2data);
+	if (P->Files) 
+		for (int i=0; i<P->NbFiles; i++) free(P->Files[i].Subsystem);
+	free(P->Files);
+	free(P->Slots);
+	free(P->Threads);
+	free(P->RootDirName);
+	free(P);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Batch reading of many small files. With io_uring, all the opens, stats, reads and closes are queued 
+// and submitted together, and each file is decoded as soon as its data has arrived.
+// Otherwise, or if io_uring is not allowed, a few threads read the files with N2_ReadFile()
+///////////////////////////////////////////////////////////////////////////////
+
+#define N2_BATCH_INFLIGHT 64				// Max number of files open at the same time
+#define N2_BATCH_MAX_SIZE (64*1024*1024)	// Bigger data files are read by ReadData() afterwards
+
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	Thread pool fallback. Arg is a tBatchPool
+///////////////////////////////////////////////////////////////////////////////
+typedef struct sBatchPool {
+	const char **Paths;
+	tN2data *N2data;
+	long long *Results;
+	int NbFiles, Next;
+} tBatchPool;
+
+static void* ReadBatchFiles(void* Arg) {
+	tBatchPool *B=Arg;
+	for (int i; (i=__sync_fetch_and_add(&B->Next, 1))<B->NbFiles; )
+		B->Results[i]=N2_ReadFile(B->Paths[i], &B->N2data[i]);
+	return NULL;
+}
+
+static void ReadBatchPool(const char* ConfigPathNames[], int NbFiles, tN2data N2data[], long long Results[]) {
+	tBatchPool B={ .Paths=ConfigPathNames, .N2data=N2data, .Results=Results, .NbFiles=NbFiles };
+	int NbThreads=(int)sysconf(_SC_NPROCESSORS_ONLN);
+	if (NbThreads>NbFiles) NbThreads=NbFiles;
+	if (NbThreads<1) NbThreads=1;
+	pthread_t Threads[NbThreads];
+	int Started=0;
+	for (; Started<NbThreads-1; Started++)
+		if (pthread_create(&Threads[Started], NULL, ReadBatchFiles, &B)) break;
+	ReadBatchFiles(&B);
+	for (int t=0; t<Started; t++) pthread_join(Threads[t], NULL);
+}
+
+#ifdef N2_HAVE_URING
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	Minimal io_uring: the two rings mapped from the kernel
+///////////////////////////////////////////////////////////////////////////////
+typedef struct sURing {
+	int fd;
+	unsigned *SqHead, *SqTail, SqMask, *SqArray;
+	unsigned *CqHead, *CqTail, CqMask;
+	struct io_uring_sqe *Sqes;
+	struct io_uring_cqe *Cqes;
+	void *SqMap, *CqMap;
+	size_t SqMapSize, CqMapSize, SqesSize;
+	unsigned ToSubmit;
+} tURing;
+
+static void URingExit(tURing *U) {
+	if (U->Sqes) munmap(U->Sqes, U->SqesSize);
+	if (U->CqMap and U->CqMap!=U->SqMap) munmap(U->CqMap, U->CqMapSize);
+	if (U->SqMap) munmap(U->SqMap, U->SqMapSize);
+	if (U->fd>=0) close(U->fd);
+	bzero(U, sizeof(tURing));
+	U->fd=-1;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	Check that the kernel knows all the operations used by the batch reader
+/// HIFN	Older kernels (5.1 to 5.5) have io_uring, but not open/statx/read/close, nor the probe itself
+/// HIRET	-errno or 0
+///////////////////////////////////////////////////////////////////////////////
+static int URingProbe(int fd) {
+	static const int Ops[]={ IORING_OP_OPENAT, IORING_OP_STATX, IORING_OP_READ, IORING_OP_CLOSE };
+	const int NbProbe=64;
+	struct io_uring_probe *Probe=calloc(1, sizeof(struct io_uring_probe)+NbProbe*sizeof(struct io_uring_probe_op));
+	if (Probe==NULL) return -(errno=ENOMEM);
+	int R=0;
+	if (syscall(__NR_io_uring_register, fd, IORING_REGISTER_PROBE, Probe, NbProbe)<0) R=-errno;
+	else for (unsigned k=0; k<sizeof(Ops)/sizeof(Ops[0]) and R==0; k++)
+		if (Ops[k]>Probe->last_op or !(Probe->ops[Ops[k]].flags & IO_URING_OP_SUPPORTED)) R=-(errno=EOPNOTSUPP);
+	free(Probe);
+	return R;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// HIRET	-errno or 0
+///////////////////////////////////////////////////////////////////////////////
+static int URingInit(tURing *U, unsigned Entries) {
+	struct io_uring_params P;
+	bzero(U, sizeof(tURing)); bzero(&P, sizeof(P));
+	if ((U->fd=syscall(__NR_io_uring_setup, Entries, &P))<0) { U->fd=-1; return -errno; }
+	if (URingProbe(U->fd)<0) goto Error;
+	U->SqMapSize=P.sq_off.array+P.sq_entries*sizeof(unsigned);
+	U->CqMapSize=P.cq_off.cqes +P.cq_entries*sizeof(struct io_uring_cqe);
+	if (P.features & IORING_FEAT_SINGLE_MMAP) 
+		U->SqMapSize=U->CqMapSize=(U->SqMapSize>U->CqMapSize ? U->SqMapSize : U->CqMapSize);
+	U->SqMap=mmap(NULL, U->SqMapSize, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_POPULATE, U->fd, IORING_OFF_SQ_RING);
+	if (U->SqMap==MAP_FAILED) { U->SqMap=NULL; goto Error; }
+	if (P.features & IORING_FEAT_SINGLE_MMAP) U->CqMap=U->SqMap;
+	else {
+		U->CqMap=mmap(NULL, U->CqMapSize, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_POPULATE, U->fd, IORING_OFF_CQ_RING);
+		if (U->CqMap==MAP_FAILED) { U->CqMap=NULL; goto Error; }
+	}
+	U->SqesSize=P.sq_entries*sizeof(struct io_uring_sqe);
+	U->Sqes=mmap(NULL, U->SqesSize, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_POPULATE, U->fd, IORING_OFF_SQES);
+	if (U->Sqes==MAP_FAILED) { U->Sqes=NULL; goto Error; }
+	
+	char *Sq=U->SqMap, *Cq=U->CqMap;
+	U->SqHead =(unsigned*)(Sq+P.sq_off.head);
+	U->SqTail =(unsigned*)(Sq+P.sq_off.tail);
+	U->SqMask =*(unsigned*)(Sq+P.sq_off.ring_mask);
+	U->SqArray=(unsigned*)(Sq+P.sq_off.array);
+	U->CqHead =(unsigned*)(Cq+P.cq_off.head);
+	U->CqTail =(unsigned*)(Cq+P.cq_off.tail);
+	U->CqMask =*(unsigned*)(Cq+P.cq_off.ring_mask);
+	U->Cqes   =(struct io_uring_cqe*)(Cq+P.cq_off.cqes);
+	return 0;
+
+Error:;
+	int R=-errno;
+	URingExit(U);
+	return R;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	Next free submission entry, cleared. Only queued, see URingSubmit()
+/// HIRET	NULL if the ring is full
+///////////////////////////////////////////////////////////////////////////////
+static struct io_uring_sqe* URingGetSqe(tURing *U, unsigned long long UserData) {
+	unsigned Tail=*U->SqTail;
+	if (Tail-__atomic_load_n(U->SqHead, __ATOMIC_ACQUIRE)>U->SqMask) return NULL;
+	struct io_uring_sqe *Sqe=&U->Sqes[Tail & U->SqMask];
+	bzero(Sqe, sizeof(*Sqe));
+	Sqe->user_data=UserData;
+	U->SqArray[Tail & U->SqMask]=Tail & U->SqMask;
+	__atomic_store_n(U->SqTail, Tail+1, __ATOMIC_RELEASE);
+	U->ToSubmit++;
+	return Sqe;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	Submit everything queued and wait for at least WaitNb completions, in a single system call
+///////////////////////////////////////////////////////////////////////////////
+static int URingSubmit(tURing *U, unsigned WaitNb) {
+	int R;
+	do R=syscall(__NR_io_uring_enter, U->fd, U->ToSubmit, WaitNb, WaitNb ? IORING_ENTER_GETEVENTS : 0, NULL, 0);
+	while (R<0 and errno==EINTR);
+	if (R<0) return -errno;
+	U->ToSubmit-=((unsigned)R<U->ToSubmit ? (unsigned)R : U->ToSubmit);
+	return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	State of one file of the batch
+///////////////////////////////////////////////////////////////////////////////
+enum { OP_OPEN_HD, OP_OPEN_DAT, OP_STAT_HD, OP_STAT_DAT, OP_READ_HD, OP_READ_DAT, OP_CLOSE, NB_OP };
+#define URING_DATA(File, Op) (((unsigned long long)(File)<<4) | (Op))
+
+typedef struct sBatchFile {
+	int FdHd, FdDat;
+	int Pending;				// Number of operations in flight
+	int Done;					// Bit per completed operation
+	int Err;
+	int Fallback;				// Too big, read later by ReadData()
+	struct statx StHd, StDat;
+	char *Text;					// Content of the .hd
+	long long *Buf;				// Content of the .EDMdat
+	long long Got;				// Bytes of Text or Buf read so far
+	char DataPath[PATH_MAX];
+} tBatchFile;
+
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	Decode a data file that is entirely in memory, like ReadData() does
+///////////////////////////////////////////////////////////////////////////////
+static long long DecodeFile(tN2data *N2data, const char* PathName, const long long *Buf, long long Size) {
+	size_t RecSize=(FILE_NBCOL(N2data)+1)*8;
+	long long NbRec=Size/RecSize;
+	N2data->DataPathname=N2strdup(N2data, PathName);
+	if (N2data->DataPathname==NULL) return -(errno=ENOMEM);
+	if (SetRelTimeColumn(N2data)<0) return -errno;
+	if (AllocRows(N2data, NbRec)<0) return -errno;
+	N2data->ReservedSize=NbRec;
+	int BlockRows=N2_BLOCK_SIZE/RecSize, NbBad=0;
+	if (BlockRows<1) BlockRows=1;
+	for (long long r=0; r<NbRec; r+=BlockRows) {
+		int Nb=(NbRec-r<BlockRows ? (int)(NbRec-r) : BlockRows);
+		int R=DecodeBlock(N2data, Buf+r*(RecSize/8), Nb, r, N2data->FirstTimeStamp);
+		if (R<0) return R;
+		NbBad+=R;
+		N2data->NbRow=r+Nb;
+	}
+	if (NbBad) SLOG(SERR, "%d wrong EOL markers (expecting 0x%llX)", NbBad, N2data->EOLidentifier);
+	SLOG(SNTC, "NbRow=%lld", N2data->NbRow);
+	return N2data->NbRow;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	Queue the next operation(s) of a file, depending on what is done
+/// HIRET	0, or -EAGAIN if the ring is full (try again after some completions)
+///////////////////////////////////////////////////////////////////////////////
+#define DONE(Op) (F->Done & 1<<(Op))
+static int BatchNext(tURing *U, tBatchFile *F, int i, const char* ConfigPathName, tN2data *N2data, long long *Result) {
+	struct io_uring_sqe *Sqe;
+	if (F->Err) {
+		if (F->Pending) return 0;	// Wait for the rest before closing
+		*Result=-F->Err;
+		goto Close;
+	}
+	if (DONE(OP_READ_DAT)) goto Close;	// Ring was full when closing
+	if (!F->Err and !DONE(OP_READ_HD) and DONE(OP_OPEN_HD) and DONE(OP_STAT_HD) and F->Text==NULL) {
+		if (NULL==(F->Text=malloc(F->StHd.stx_size+1))) { F->Err=ENOMEM; return BatchNext(U, F, i, ConfigPathName, N2data, Result); }
+		F->Got=0;
+	}
+	if (!F->Err and F->Text and !DONE(OP_READ_HD) and F->Pending==0) {	// Or the rest after a short read
+		if (F->Got>=(long long)F->StHd.stx_size) {
+			F->Done|=1<<OP_READ_HD;
+			F->Text[F->Got]='\0';
+			int R=ReadConfig(ConfigPathName, F->Text, N2data, 1);
+			if (R<0) F->Err=-R;
+			free(F->Text); F->Text=NULL;
+			return BatchNext(U, F, i, ConfigPathName, N2data, Result);
+		}
+		if (NULL==(Sqe=URingGetSqe(U, URING_DATA(i, OP_READ_HD)))) return -EAGAIN;
+		Sqe->opcode=IORING_OP_READ; Sqe->fd=F->FdHd;
+		Sqe->addr=(unsigned long long)(F->Text+F->Got); Sqe->len=F->StHd.stx_size-F->Got; Sqe->off=F->Got;
+		F->Pending++;
+		return 0;
+	}
+	if (!F->Err and DONE(OP_READ_HD) and DONE(OP_OPEN_DAT) and DONE(OP_STAT_DAT) and !DONE(OP_READ_DAT) and F->Pending==0) {
+		long long Size=F->StDat.stx_size/((FILE_NBCOL(N2data)+1)*8)*((FILE_NBCOL(N2data)+1)*8);	// Whole records
+		if (F->Buf==NULL) {
+			if (Size>N2_BATCH_MAX_SIZE) { F->Fallback=1; F->Done|=1<<OP_READ_DAT; goto Close; }
+			if (NULL==(F->Buf=AlignedAlloc(Size))) { F->Err=ENOMEM; return BatchNext(U, F, i, ConfigPathName, N2data, Result); }
+			F->Got=0;
+		}
+		if (F->Got>=Size) {
+			F->Done|=1<<OP_READ_DAT;
+			*Result=DecodeFile(N2data, F->DataPath, F->Buf, Size);
+			if (*Result<0) F->Err=-*Result;
+			free(F->Buf); F->Buf=NULL;
+			goto Close;
+		}
+		if (NULL==(Sqe=URingGetSqe(U, URING_DATA(i, OP_READ_DAT)))) return -EAGAIN;
+		Sqe->opcode=IORING_OP_READ; Sqe->fd=F->FdDat;
+		Sqe->addr=(unsigned long long)((char*)F->Buf+F->Got); Sqe->len=(Size-F->Got>0x40000000 ? 0x40000000 : Size-F->Got); Sqe->off=F->Got;
+		F->Pending++;
+		return 0;
+	}
+	return 0;	// Waiting for something
+
+Close:
+	for (int k=0; k<2; k++) {
+		int *Fd=(k==0 ? &F->FdHd : &F->FdDat);
+		if (*Fd<0) continue;
+		if (NULL==(Sqe=URingGetSqe(U, URING_DATA(i, OP_CLOSE)))) return -EAGAIN;
+		Sqe->opcode=IORING_OP_CLOSE; Sqe->fd=*Fd;
+		*Fd=-1;
+		F->Pending++;
+	}
+	if (F->Text) { free(F->Text); F->Text=NULL; }
+	if (F->Buf ) { free(F->Buf ); F->Buf =NULL; }
+	F->Done|=1<<OP_CLOSE;
+	return 0;
+}
+#undef DONE
+
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	Queue the opens and stats of a file
+/// HIRET	0, or -EAGAIN if the ring is full
+///////////////////////////////////////////////////////////////////////////////
+static int BatchStart(tURing *U, tBatchFile *F, int i, const char* ConfigPathName) {
+	if (U->SqMask+1-(*U->SqTail-__atomic_load_n(U->SqHead, __ATOMIC_ACQUIRE))<4) return -EAGAIN;
+	strcpy(F->DataPath, ConfigToDataName(ConfigPathName));
+	const char *Path[2]={ConfigPathName, F->DataPath};
+	for (int k=0; k<2; k++) {
+		struct io_uring_sqe *Sqe=URingGetSqe(U, URING_DATA(i, k==0 ? OP_OPEN_HD : OP_OPEN_DAT));
+		Sqe->opcode=IORING_OP_OPENAT; Sqe->fd=AT_FDCWD; Sqe->addr=(unsigned long long)Path[k]; Sqe->open_flags=O_RDONLY;
+		Sqe=URingGetSqe(U, URING_DATA(i, k==0 ? OP_STAT_HD : OP_STAT_DAT));
+		Sqe->opcode=IORING_OP_STATX; Sqe->fd=AT_FDCWD; Sqe->addr=(unsigned long long)Path[k]; 
+		Sqe->len=STATX_SIZE; Sqe->off=(unsigned long long)(k==0 ? &F->StHd : &F->StDat);
+	}
+	F->Pending=4;
+	return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	After an error, wait for all the operations in flight, which may still write to the buffers
+/// HIFN	The files opened meanwhile get their fd set, to be closed by the caller
+/// HIRET	Number of files with operations still in flight, if the ring cannot be waited on anymore
+///////////////////////////////////////////////////////////////////////////////
+static int BatchDrain(tURing *U, tBatchFile *Files, int Started) {
+	for (int Tries=0; ; ) {
+		int Left=0;
+		for (int i=0; i<Started; i++) Left+=(Files[i].Pending>0);
+		if (Left==0) return 0;
+		int R=URingSubmit(U, 1);
+		unsigned Head=*U->CqHead, Tail=__atomic_load_n(U->CqTail, __ATOMIC_ACQUIRE);
+		if (R<0 and Head==Tail and ++Tries>=100) return Left;	// No progress
+		for (; Head!=Tail; Head++) {
+			struct io_uring_cqe *Cqe=&U->Cqes[Head & U->CqMask];
+			int Op=Cqe->user_data & 0xF, Res=Cqe->res;
+			tBatchFile *F=&Files[Cqe->user_data>>4];
+			F->Pending--;
+			if      (Op==OP_OPEN_HD  and Res>=0) F->FdHd =Res;
+			else if (Op==OP_OPEN_DAT and Res>=0) F->FdDat=Res;
+		}
+		__atomic_store_n(U->CqHead, Head, __ATOMIC_RELEASE);
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// HIRET	-errno if io_uring cannot be used, or 0
+///////////////////////////////////////////////////////////////////////////////
+static int ReadBatchURing(const char* ConfigPathNames[], int NbFiles, tN2data N2data[], long long Results[]) {
+	tURing U;
+	int R=URingInit(&U, 4*N2_BATCH_INFLIGHT);
+	if (R<0) { SLOG(SNTC, "io_uring not available: %s", strerror(-R)); return R; }
+	tBatchFile *Files=calloc(NbFiles, sizeof(tBatchFile));
+	if (Files==NULL) { URingExit(&U); return -(errno=ENOMEM); }
+	
+	int Started=0, Finished=0, InFlight=0, Again=0;
+	while (Finished<NbFiles) {
+		// Start new files while there is room
+		while (Started<NbFiles and InFlight<N2_BATCH_INFLIGHT) {
+			tBatchFile *F=&Files[Started];
+			F->FdHd=F->FdDat=-1;
+			if (strlen(ConfigPathNames[Started])<8 or strlen(ConfigPathNames[Started])>=PATH_MAX) { 
+				F->Done=1<<OP_CLOSE | 1<<NB_OP;
+				Results[Started++]=-(errno=ENOENT); Finished++; continue; }
+			if (BatchStart(&U, F, Started, ConfigPathNames[Started])<0) break;
+			Started++; InFlight++;
+		}
+		if (Finished==NbFiles) break;
+		if ((R=URingSubmit(&U, Again ? 0 : 1))<0) break;
+		
+		// Handle the completions
+		unsigned Head=*U.CqHead, Tail=__atomic_load_n(U.CqTail, __ATOMIC_ACQUIRE);
+		for (; Head!=Tail; Head++) {
+			struct io_uring_cqe *Cqe=&U.Cqes[Head & U.CqMask];
+			int i=Cqe->user_data>>4, Op=Cqe->user_data & 0xF, Res=Cqe->res;
+			tBatchFile *F=&Files[i];
+			F->Pending--;
+			if (Op==OP_CLOSE) ;
+			else if (Res<0) { if (!F->Err) F->Err=-Res; }
+			else switch (Op) {
+				case OP_OPEN_HD:  F->FdHd =Res; F->Done|=1<<Op; break;
+				case OP_OPEN_DAT: F->FdDat=Res; F->Done|=1<<Op; break;
+				case OP_STAT_HD:  case OP_STAT_DAT: F->Done|=1<<Op; break;
+				case OP_READ_HD:  case OP_READ_DAT:
+					if (Res==0) F->Err=EIO;	// Shrunk under our feet
+					F->Got+=Res; break;
+			}
+			if (!(F->Done & 1<<OP_CLOSE) and BatchNext(&U, F, i, ConfigPathNames[i], &N2data[i], &Results[i])==-EAGAIN) Again=1;
+			if (F->Done & 1<<OP_CLOSE and F->Pending==0 and !(F->Done & 1<<NB_OP)) {
+				F->Done|=1<<NB_OP;	// Finished
+				Finished++; InFlight--;
+			}
+		}
+		__atomic_store_n(U.CqHead, Head, __ATOMIC_RELEASE);
+		if (Again) {	// The ring was full: go through the files waiting for a free entry
+			Again=0;
+			for (int i=0; i<Started; i++) {
+				tBatchFile *F=&Files[i];
+				if (!(F->Done & 1<<OP_CLOSE) and F->Pending==0 and BatchNext(&U, F, i, ConfigPathNames[i], &N2data[i], &Results[i])==-EAGAIN) Again=1;
+				if (F->Done & 1<<OP_CLOSE and F->Pending==0 and !(F->Done & 1<<NB_OP)) {
+					F->Done|=1<<NB_OP;
+					Finished++; InFlight--;
+				}
+			}
+		}
+	}
+	
+	if (R<0) {	// The ring failed, should not happen. Close what's open and redo the unfinished files
+		SLOG(SERR, "io_uring error: %s", strerror(-R));
+		int Left=BatchDrain(&U, Files, Started);	// Nothing can be freed while the kernel may write to it
+		for (int i=0; i<Started; i++) {
+			if (Files[i].FdHd >=0) close(Files[i].FdHd);
+			if (Files[i].FdDat>=0) close(Files[i].FdDat);
+			if (Files[i].Pending==0) { free(Files[i].Text); free(Files[i].Buf); }
+		}
+		URingExit(&U);
+		for (int i=0; i<NbFiles; i++)
+			if (!(Files[i].Done & 1<<NB_OP)) Results[i]=N2_ReadFile(ConfigPathNames[i], &N2data[i]);
+		if (Left) SLOG(SERR, "%d files still in flight, their buffers are not freed", Left);
+		else free(Files);	// Also holds the statx buffers
+		return 0;
+	}
+	URingExit(&U);
+	
+	for (int i=0; i<NbFiles; i++) 	// Large files
+		if (Files[i].Fallback and !Files[i].Err) 
+			Results[i]=ReadData(Files[i].DataPath, &N2data[i], 0, 0, 0);
+	free(Files);
+	return 0;
+}
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	Read many files (header and data) at once. Same result as N2_ReadFile() on each of them
+/// HIFN	Uses io_uring when possible, to submit all the system calls together, otherwise a pool of threads
+/// HIPAR	N2data / Array of NbFiles structures. Set their reading options (Columnar...) before if needed
+/// HIPAR	Results / Array of NbFiles results: -errno or number of rows of each file
+/// HIRET	Number of files read without error
+///////////////////////////////////////////////////////////////////////////////
+int N2_ReadBatch(const char* ConfigPathNames[], int NbFiles, tN2data N2data[], long long Results[]) {
+	SLOG(SDBG, "Enter: %d files", NbFiles);
+	if (NbFiles<=0) return 0;
+#ifdef N2_HAVE_URING
+	if (ReadBatchURing(ConfigPathNames, NbFiles, N2data, Results)<0)
+#endif
+		ReadBatchPool(ConfigPathNames, NbFiles, N2data, Results);
+	int Nb=0;
+	for (int i=0; i<NbFiles; i++) Nb+=(Results[i]>=0);
+	return Nb;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// Glue code. See SimpleLog.c for sytax
+///////////////////////////////////////////////////////////////////////////////
+void N2_LogSetup(const char *PathName, 
+					const char *TimeFormat, 
+					const int NoRepeatLastN, 
+					const int RepeatMaxCount,
+					const int RepeatMaxSeconds,
+					const char *Separator) {
+	SimpleLog_Setup(PathName, TimeFormat, NoRepeatLastN, RepeatMaxCount, RepeatMaxSeconds, Separator);
+}
+
+int N2_LogFilterLevel(const int LogLevel) {
+	return SimpleLog_FilterLevel(LogLevel);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// And now for the features to find the data files
+///////////////////////////////////////////////////////////////////////////////
+
+#include <dirent.h>	// For directory-related stuff on Linux
+//#include <config.h>
+//#include <gl_oset.h>
+
+#define DEF_ALLOC 1000000		// NOTE: Should be 10^6 for number of possible Cycle numbers
+#define CATALOG_NAME ".N2catalog"	// In the root directory, see N2_UpdateCatalog()
+
+// One header file of the catalog. Sorted like the file names: by RunNo, CycNo, SizeIdx, Subsystem name
+typedef struct sCatEntry {
+	int RunNo, CycNo, SizeIdx, HdrVer;
+	int Subs;					// Index in tCatalog.Subs, or -1 for a run directory without any header
+	int NbCol;
+	long long NbRow;			// From the size of the data file, or -errno
+	long long FirstTimeStamp, LastTimeStamp;	// From the header, 0 if it can't be read
+} tCatEntry;
+
+typedef struct sCatalog {
+	int Direct, NbSubs;
+	long long NbEntries;
+	char **Subs;				// Subsystem names
+	tCatEntry *Entries;
+} tCatalog;
+
+static const tCatalog* GetCatalog(const char* RootDirName, int Direct);
+static long long CatalogFindRun(const tCatalog *Cat, int RunNo);
+
+static int CompareInt(const void *A, const void *B) { 
+	return *(int*)A-*(int*)B; 
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// WARNING: A and B are not equivalent. You figure it out...
+///////////////////////////////////////////////////////////////////////////////
+static int CompareStr(const void *A, const void *B) { 
 //	printf("\nA:%p, B:%p", A, B);
 //	printf("\nA:%p, B:%p", (char*)A, (char*)B);
 //	printf("\nA:%p, B:%p\n", *(char**)A, *(char**)B);
@@ -620,322 +3050,1437 @@ static int CompareStr(const void *A, const void *B) {
 }
 
 ///////////////////////////////////////////////////////////////////////////////
-/// HIFN	Remove duplicates from array
-/// HIFN	Compar / Comparision function
-/// HIRET	New number of elements
+/// HIFN	Remove duplicates from array
+/// HIFN	Compar / Comparision function
+/// HIRET	New number of elements
+///////////////////////////////////////////////////////////////////////////////
+static int RmDups(void* Array, int Nb, int size, int (*Compar)(const void*, const void*)) {
+	if (Nb==0 or Nb==1) return Nb;
+	int j=1;	// In place, no copy of the array on the stack
+	for (int i=1; i<Nb; i++)
+		if (0!=Compar((char*)Array+(j-1)*size, (char*)Array+i*size)) {
+			if (i!=j) memcpy((char*)Array+j*size, (char*)Array+i*size, size);
+			j++;
+		}
+	return j;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	Look for an item in an array
+/// HIFN	Compar / Comparision function
+/// HIRET	1 if item is found in (unsorted) array
+///////////////////////////////////////////////////////////////////////////////
+static int FindInArray(void* Item, void* Array, int Nb, int Size, int (*Compar)(const void*,const void*)) {
+//	printf("\nEnter Item:%p, Nb:%d, Size:%d", Item, Nb, Size);
+	for (int i=0; i<Nb; i++) {
+		if (0==Compar(Item, (char*)Array+Size*i)) 
+			return 1;
+	}
+	return 0;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	Parse a header file name RunNo_CycNo_SizeIdx_Subsystem_HdrVer.hd, like sscanf("%6d_%6d_%3d_%[^.].hd")
+/// HIFN	but faster, and without overflowing Subs
+/// HIPAR	Subs / Receives the subsystem name, without the _HdrVer
+/// HIRET	1 if it is a header file name
+///////////////////////////////////////////////////////////////////////////////
+#define N2_SUBS_MAX 80
+static int MatchHeaderName(const char* Name, int *RunNo, int *CycNo, int *SizeIdx, char Subs[N2_SUBS_MAX], int *HdrVer) {
+	const char *C=Name;
+	int V[3];
+	for (int k=0; k<3; k++) {
+		int n=0, Max=(k<2 ? 6 : 3);
+		for (V[k]=0; n<Max and *C>='0' and *C<='9'; n++) V[k]=V[k]*10+*C++-'0';
+		if (n==0 or *C++!='_') return 0;
+	}
+	const char *End=C;	// ".hd" must be the first '.' and the end
+	while (*End and *End!='.') End++;
+	if (End[0]!='.' or End[1]!='h' or End[2]!='d' or End[3]!='\0') return 0;
+	const char *U=End;
+	while (U>C and *U!='_') U--;	// Because it's like coils_000 or some_other_stuff_000
+	if (U==C or U-C>=N2_SUBS_MAX) return 0;
+	memcpy(Subs, C, U-C); Subs[U-C]='\0';
+	*RunNo=V[0]; *CycNo=V[1]; *SizeIdx=V[2]; 
+	*HdrVer=0;
+	for (U++; *U>='0' and *U<='9'; U++) *HdrVer=*HdrVer*10+*U-'0';
+	return 1;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	Same as MatchHeaderName() for a data file: RunNo_CycNo_SizeIdx_Subsystem.EDMdat
+///////////////////////////////////////////////////////////////////////////////
+static int MatchDataName(const char* Name, int *RunNo, int *CycNo, int *SizeIdx, char Subs[N2_SUBS_MAX]) {
+	const char *C=Name;
+	int V[3];
+	for (int k=0; k<3; k++) {
+		int n=0, Max=(k<2 ? 6 : 3);
+		for (V[k]=0; n<Max and *C>='0' and *C<='9'; n++) V[k]=V[k]*10+*C++-'0';
+		if (n==0 or *C++!='_') return 0;
+	}
+	const char *End=C;
+	while (*End and *End!='.') End++;
+	if (0!=strcmp(End, ".EDMdat") or End==C or End-C>=N2_SUBS_MAX) return 0;
+	memcpy(Subs, C, End-C); Subs[End-C]='\0';
+	*RunNo=V[0]; *CycNo=V[1]; *SizeIdx=V[2]; 
+	return 1;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	Find all the parts (cycles and their SizeIdx) of a run for one subsystem
+/// HIPAR	Parts / Returned array of CycNo*1000+SizeIdx, sorted, so in time order. You should free it
+/// HIRET	Number of parts found (or -errno)
+///////////////////////////////////////////////////////////////////////////////
+static int GetRunParts(const char* RootDirName, int Direct, int RunNo, const char* Subsystem, int *Parts[]) {
+	char DirPath[PATH_MAX];
+	if (Direct) snprintf(DirPath, sizeof(DirPath), "%s",           RootDirName);
+	else        snprintf(DirPath, sizeof(DirPath), "%s/%03i/%03i", RootDirName, RunNo/1000, RunNo%1000);
+	*Parts=NULL;
+	DIR *D=opendir(DirPath);
+	if (D==NULL) { SLOG(SERR, "Cannot open %s: %s", DirPath, strerror(errno)); return -errno; }
+	int Nb=0, Size=0, R=0;
+	for (struct dirent *E; (E=readdir(D)); ) {
+		int Rn, Cn, Si, Hv;
+		char SubS[N2_SUBS_MAX];
+		if (!MatchHeaderName(E->d_name, &Rn, &Cn, &Si, SubS, &Hv) or Rn!=RunNo or strcmp(SubS, Subsystem)) continue;
+		if (Nb==Size) {
+			int *New=realloc(*Parts, (Size=2*Size+64)*sizeof(int));
+			if (New==NULL) { R=-(errno=ENOMEM); break; }
+			*Parts=New;
+		}
+		(*Parts)[Nb++]=Cn*1000+Si;
+	}
+	closedir(D);
+	if (R<0) { free(*Parts); *Parts=NULL; return R; }
+	qsort(*Parts, Nb, sizeof(int), CompareInt);
+	return RmDups(*Parts, Nb, sizeof(int), CompareInt);	// Several HdrVer of the same part
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	Find the run numbers available in a given directory
+/// HIPAR	Direct / 0: Look for directories names /RunNo/1000/RunNo%1000/ in RootDirName
+/// HIPAR	Direct / 1: Look for files named RunNo_... in RootDirName
+/// HIPAR	RunNoList / Returned array of RunNo, passed by reference, 
+/// HIPAR	RunNoList / initially NULL, you should free it at the end of the prog, otherwise it's reused
+/// HIPAR	StartFromRunNo / Start search from this run (0 by default) to speed cache refresh
+/// HIRET	Number of runs found (or -errno)
+///////////////////////////////////////////////////////////////////////////////
+int N2_GetRunNumbers(const char* RootDirName, int Direct, int *RunNoList[], 
+					 const int StartFromRunNo) {
+	int Nb=0;
+	//	SLOG(SDBG, "Enter");
+	errno=0;
+	//	if (*RunNoList) free(*RunNoList);
+	//	*RunNoList=calloc(DEF_ALLOC, sizeof(int));	// Max size with 3 digits
+	*RunNoList=realloc(*RunNoList, DEF_ALLOC*sizeof(int));	// Max size with 6 digits (direct) or 3 (indirect)
+	if (*RunNoList==NULL) return -(errno=ENOMEM);
+	
+	const tCatalog *Cat=GetCatalog(RootDirName, Direct);
+	if (Cat) {	// Already sorted
+		for (long long i=CatalogFindRun(Cat, StartFromRunNo); i<Cat->NbEntries and Nb<DEF_ALLOC; i++)
+			if (Nb==0 or (*RunNoList)[Nb-1]!=Cat->Entries[i].RunNo) (*RunNoList)[Nb++]=Cat->Entries[i].RunNo;
+		return Nb;
+	}
+	
+	#pragma GCC diagnostic push
+	#pragma GCC diagnostic ignored "-Wpedantic"
+	/// HIFN	Return 1 if the name is a header file %6d_%6d_%3d_%[^.].hd
+	int FilterHeaderNames(const struct dirent* dir) {
+		int Rn=0, Cn, Si, Hv;
+		char SubS[N2_SUBS_MAX];
+		return strlen(dir->d_name)>22 and 
+		MatchHeaderName(dir->d_name, &Rn, &Cn, &Si, SubS, &Hv) and	// This way we match only header files
+		Rn>=StartFromRunNo;
+	}
+	
+	/// HIFN	Return 1 if the string is exactly 3 digits assumed to be thousands
+	int Filter3digitsK(const struct dirent* dir) {
+		return strlen(dir->d_name)==3 and 
+		'0'<=dir->d_name[0] and dir->d_name[0]<='9' and 
+		'0'<=dir->d_name[1] and dir->d_name[1]<='9' and 
+		'0'<=dir->d_name[2] and dir->d_name[2]<='9' and
+		atoi(dir->d_name)>=StartFromRunNo/1000; 
+	}
+	
+	/// HIFN	Return 1 if the string is exactly 3 digits assumed to be units, in the thousands directory ThisK
+	int ThisK=0;
+	int Filter3digitsU(const struct dirent* dir) {
+		return strlen(dir->d_name)==3 and 
+		'0'<=dir->d_name[0] and dir->d_name[0]<='9' and 
+		'0'<=dir->d_name[1] and dir->d_name[1]<='9' and 
+		'0'<=dir->d_name[2] and dir->d_name[2]<='9' and
+		ThisK*1000+atoi(dir->d_name)>=StartFromRunNo; 
+	}
+	#pragma GCC diagnostic pop
+	
+	if (Direct) {
+		struct dirent **hlist;
+		int h = scandir(RootDirName, &hlist, FilterHeaderNames, alphasort);
+		if (h == -1) { perror("scandir"); return -errno; }
+		
+		for (int i=0; i<h; i++) {
+			//			printf("%s\n", hlist[i]->d_name);
+			(*RunNoList)[Nb++]=atoi(hlist[i]->d_name);
+			free(hlist[i]);
+		}
+		free(hlist);
+	} else {
+		struct dirent **klist=NULL;
+		int k = scandir(RootDirName, &klist, Filter3digitsK, alphasort);
+		if (k == -1) { perror("scandir"); return -errno; }
+		
+		for (int i=0; i<k; i++) {
+			//			printf("%s\n", klist[i]->d_name);
+			
+			// Recurse 2nd level
+			struct dirent **plist=NULL;
+			int p;
+			
+			char Sub[1024];
+			sprintf(Sub, "%s/%s", RootDirName, klist[i]->d_name);
+			ThisK=atoi(klist[i]->d_name);
+			p = scandir(Sub, &plist, Filter3digitsU, alphasort);
+			if (p == -1) { perror("scandir2"); return -errno; }
+			
+			for (int j=0; j<p; j++) {
+				//				printf("%s/%s\n", klist[i]->d_name, plist[j]->d_name);
+				(*RunNoList)[Nb++] = atoi(klist[i]->d_name)*1000 + atoi(plist[j]->d_name);
+				free(plist[j]); plist[j]=NULL;
+			}
+			free(plist);    plist   =NULL;
+			free(klist[i]); klist[i]=NULL;
+		}
+		free(klist); klist=NULL;
+	}
+	// NOTE: RunNoList should already be sorted by the alphasort function
+	qsort(    *RunNoList, Nb, sizeof(int), CompareInt);	// qsort *is* thread safe if you don't use global variables in the comparision function
+	Nb=RmDups(*RunNoList, Nb, sizeof(int), CompareInt);
+	//	*RunNoList=realloc(*RunNoList, Nb*sizeof(int));		// Optional
+	//	if (*RunNoList==NULL) return -(errno=ENOMEM);
+	return errno ? -errno : Nb;
+}
+
+#if 0
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	Find the run numbers available in a given directory
+/// HIPAR	Direct / 0: Look for directories names /RunNo/1000/RunNo%1000/ in RootDirName
+/// HIPAR	Direct / 1: Look for files named RunNo_... in RootDirName
+/// HIPAR	RunNoList / Returned array of RunNo, passed by reference, 
+/// HIPAR	RunNoList / initially NULL, you should free it at the end of the prog, otherwise it's reused
+///////////////////////////////////////////////////////////////////////////////
+int N2_GetRunNumbers_Simple(const char* RootDirName, int Direct, int *RunNoList[]) {
+	int Nb=0;
+//	SLOG(SDBG, "Enter");
+	errno=0;
+//	if (*RunNoList) free(*RunNoList);
+//	*RunNoList=calloc(DEF_ALLOC, sizeof(int));	// Max size with 3 digits
+	*RunNoList=realloc(*RunNoList, DEF_ALLOC*sizeof(int));	// Max size with 3 digits
+	if (*RunNoList==NULL) return -(errno=ENOMEM);
+	
+	if (Direct) {
+		struct dirent **hlist;
+		int h = scandir(RootDirName, &hlist, FilterHeaderNames, alphasort);
+		if (h == -1) { perror("scandir"); return -errno; }
+		
+		for (int i=0; i<h; i++) {
+//			printf("%s\n", hlist[i]->d_name);
+			(*RunNoList)[Nb++]=atoi(hlist[i]->d_name);
+			free(hlist[i]);
+		}
+		free(hlist);
+	} else {
+		struct dirent **klist=NULL;
+		int k = scandir(RootDirName, &klist, Filter3digits, alphasort);
+		if (k == -1) { perror("scandir"); return -errno; }
+		
+		for (int i=0; i<k; i++) {
+//			printf("%s\n", klist[i]->d_name);
+			
+			// Recurse 2nd level
+			struct dirent **plist=NULL;
+			int p;
+			
+			char Sub[1024];
+			sprintf(Sub, "%s/%s", RootDirName, klist[i]->d_name);
+			p = scandir(Sub, &plist, Filter3digits, alphasort);
+			if (p == -1) { perror("scandir2"); return -errno; }
+			
+			for (int j=0; j<p; j++) {
+//				printf("%s/%s\n", klist[i]->d_name, plist[j]->d_name);
+				(*RunNoList)[Nb++] = atoi(klist[i]->d_name)*1000 + atoi(plist[j]->d_name);
+				free(plist[j]); plist[j]=NULL;
+			}
+			free(plist);    plist   =NULL;
+			
+			free(klist[i]); klist[i]=NULL;
+		}
+		free(klist); klist=NULL;
+	}
+	// NOTE: RunNoList should already be sorted by the alphasort function
+	qsort(    *RunNoList, Nb, sizeof(int), CompareInt);	// qsort *is* thread safe if you don't use global variables in the comparision function
+	Nb=RmDups(*RunNoList, Nb, sizeof(int), CompareInt);
+//	*RunNoList=realloc(*RunNoList, Nb*sizeof(int));		// Optional
+//	if (*RunNoList==NULL) return -(errno=ENOMEM);
+	return errno ? -errno : Nb;
+}
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	Find the subsystems available in a certain directory for a given run number
+/// HIPAR	SubsList / Returned array of CycNo, passed by reference, initially NULL, 
+/// HIPAR	SubsList / you should free it and free every substring (function will not clean it for you on re-entry)
+/// HIRET	Number of Subsystems in the SubsList array, or -errno
+///////////////////////////////////////////////////////////////////////////////
+int N2_GetSubsystems(const char* RootDirName, int Direct, int RunNo, char **SubsList[]) {
+	int Nb=0;
+	SLOG(SDBG, "Enter");
+	errno=0;
+	
+	const tCatalog *Cat=GetCatalog(RootDirName, Direct);
+	if (Cat) {	// In order of appearance, like the scandir below
+		char *Seen=calloc(Cat->NbSubs+1, 1);
+		int *Idx=malloc((Cat->NbSubs+1)*sizeof(int));
+		if (Seen==NULL or Idx==NULL) { free(Seen); free(Idx); SLOG(SERR, "Out of memory"); return -(errno=ENOMEM); }
+		for (long long i=CatalogFindRun(Cat, RunNo); i<Cat->NbEntries and Cat->Entries[i].RunNo==RunNo; i++) {
+			int S=Cat->Entries[i].Subs;
+			if (S<0 or Seen[S]) continue;
+			Seen[S]=1; Idx[Nb++]=S;
+		}
+		free(Seen);
+		char **List=realloc(*SubsList, (Nb+1)*sizeof(char*));
+		if (List==NULL) { free(Idx); SLOG(SERR, "Out of memory"); return -(errno=ENOMEM); }
+		*SubsList=List;
+		for (int i=0; i<Nb; i++)
+			if (NULL==(List[i]=strdup(Cat->Subs[Idx[i]]))) { 
+				while (i--) free(List[i]); 
+				free(Idx); 
+				SLOG(SERR, "Out of memory"); return -(errno=ENOMEM); 
+			}
+		free(Idx);
+		return Nb;
+	}
+	
+//	if (*SubsList) SLOG(SWRN, "SubsList is not NULL");
+//	*SubsList=calloc(DEF_ALLOC, sizeof(char*));	/// How many ? Probably not very many total, but temporary ?
+	*SubsList=realloc(*SubsList, DEF_ALLOC*sizeof(char*));	/// How many ? Probably not very many total, but temporary ?
+	if (*SubsList==NULL) { SLOG(SERR, "Out of memory"); return -(errno=ENOMEM); }
+	
+	#pragma GCC diagnostic push
+	#pragma GCC diagnostic ignored "-Wpedantic"
+	/// HIFN	Return 1 if the name is a header file %6d_%6d_%3d_%[^.].hd matching RunNo
+	int FilterHeaderNamesForR(const struct dirent* dir) {
+		int Rn, Cn, Si, Hv;
+		char SubS[N2_SUBS_MAX];
+		if (!(strlen(dir->d_name)>22 and 
+			MatchHeaderName(dir->d_name, &Rn, &Cn, &Si, SubS, &Hv) and	// This way we match only header files
+			Rn==RunNo))	// Only match wanted runnumber
+			return 0;
+		if (!FindInArray(SubS, *SubsList, Nb, sizeof(char*), CompareStr)) {
+			(*SubsList)[Nb]=strdup(SubS);	// NOTE: Use N2_FreeSubsystems() to free cleanly
+			//					SLOG(SDBG, "Added: %s", SubS);
+			if ((*SubsList)[Nb]==NULL) SLOG(SERR, "Out of memory"); 
+			Nb++;
+			return 1;
+		} 
+		return 0;
+	}
+	#pragma GCC diagnostic pop
+	
+	char DirPath[PATH_MAX];
+	if (Direct) sprintf(DirPath, "%s",           RootDirName);
+	else        sprintf(DirPath, "%s/%03i/%03i", RootDirName, RunNo/1000, RunNo%1000);
+	
+	struct dirent **hlist;
+	int h = scandir(DirPath, &hlist, FilterHeaderNamesForR, alphasort);
+	if (h == -1) { perror("scandir"); return -errno; }
+	
+	for (int i=0; i<h; i++) // SubsList already filled by Filter function
+		free(hlist[i]);
+	free(hlist);
+	
+	//	qsort(    *SubsList, Nb, sizeof(int), (int (*)(const void*,const void*))strcmp);
+	//	Nb=RmDups(*SubsList, Nb, sizeof(int), (int (*)(const void*,const void*))strcmp);
+	//	*SubsList=realloc(*SubsList, Nb*sizeof(char*));	// Optional
+	if (errno) SLOG(SERR, "errno %d", errno); 
+	if (Nb==0) SLOG(SWRN, "No match in %s", DirPath);
+	return errno ? -errno : Nb;
+}
+
+void N2_FreeSubsystems(int N, char *SubsList[]) {
+	if (SubsList==NULL or *SubsList==NULL) return;
+	for (int i=0; i<N; i++) free(SubsList[i]);
+//	free(*SubsList); *SubsList=NULL;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	Find the cycle numbers available in a directory for for a given run number and subsystem 
+/// HIPAR	CycNoList / Returned array of CycNo, passed by reference, initially NULL, you should free it, or give it again to the function which will free it
+///////////////////////////////////////////////////////////////////////////////
+int N2_GetCycleNumbers(const char* RootDirName, int Direct, int RunNo, const char* Subsystem, int *CycNoList[]) {
+	int Nb=0;
+	char DirPath[PATH_MAX];
+	SLOG(SDBG, "Enter R=%d %s\n", RunNo, Subsystem);
+	errno=0;
+//	if (*CycNoList) free(*CycNoList);
+//	*CycNoList=calloc(DEF_ALLOC, sizeof(int));	// Max size with 6 digits - FIXME: that's 6 digits here
+	*CycNoList=realloc(*CycNoList, DEF_ALLOC*sizeof(int));	// Max size with 6 digits - FIXME: that's 6 digits here
+	if (*CycNoList==NULL) { SLOG(SERR, "Out of memory"); return -(errno=ENOMEM); }
+
+	const tCatalog *Cat=GetCatalog(RootDirName, Direct);
+	if (Cat) {	// Sorted by cycle
+		for (long long i=CatalogFindRun(Cat, RunNo); i<Cat->NbEntries and Cat->Entries[i].RunNo==RunNo; i++) {
+			int S=Cat->Entries[i].Subs;
+			if (S>=0 and 0==strcmp(Cat->Subs[S], Subsystem) and (Nb==0 or (*CycNoList)[Nb-1]!=Cat->Entries[i].CycNo))
+				(*CycNoList)[Nb++]=Cat->Entries[i].CycNo;
+		}
+		return Nb;
+	}
+
+	#pragma GCC diagnostic push
+	#pragma GCC diagnostic ignored "-Wpedantic"
+	/// HIFN	Return 1 if the name is a header file %6d_%6d_%3d_%[^.].hd
+	int FilterHeaderNamesForRandS(const struct dirent* dir) {
+		int Rn, Cn, Si, Hv;
+		char SubS[N2_SUBS_MAX];
+		int Res=(strlen(dir->d_name)>22 and 
+				MatchHeaderName(dir->d_name, &Rn, &Cn, &Si, SubS, &Hv) and	// This way we match only header files
+				Rn==RunNo);	// Only match wanted runnumber
+		if (!Res) return 0;
+		if (strcmp(Subsystem, SubS)==0) { (*CycNoList)[Nb++]=Cn; return 1; }	// There will be duplicates
+		return 0;
+	}
+	#pragma GCC diagnostic pop
+
+	if (Direct) sprintf(DirPath, "%s",           RootDirName);
+	else        sprintf(DirPath, "%s/%03i/%03i", RootDirName, RunNo/1000, RunNo%1000);
+	
+	struct dirent **hlist;
+	int h = scandir(DirPath, &hlist, FilterHeaderNamesForRandS, alphasort);
+	if (h == -1) { perror("scandir"); return -errno; }
+	
+	if (Nb==0) SLOG(SWRN, "No match in %s", DirPath); 
+	
+	for (int i=0; i<h; i++) free(hlist[i]);
+	free(hlist);
+
+	// NOTE: CycNoList should already be sorted by the alphasort function
+	qsort(    *CycNoList, Nb, sizeof(int), CompareInt);
+	Nb=RmDups(*CycNoList, Nb, sizeof(int), CompareInt);
+	//	*CycNoList=realloc(*CycNoList, Nb*sizeof(int));	// Optional
+	//	if (*CycNoList==NULL) return -(errno=ENOMEM);
+	if (errno) SLOG(SERR, "errno %d", errno);
+	if (Nb==0) SLOG(SWRN, "No match in %s for %s", DirPath, Subsystem);
+	return errno ? -errno : Nb;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Catalog of a data store: one file in the root directory listing every header with its row count
+// and time range, so that the functions above don't have to scan the directories.
+// File format (native byte order): magic, Direct, NbSubs, NbEntries, size of the names, 
+// the subsystem names all NUL terminated and padded to 8 bytes, then the tCatEntry array
 ///////////////////////////////////////////////////////////////////////////////
-static int RmDups(void* Array, int Nb, int size, int (*Compar)(const void*, const void*)) {
-	if (Nb==0 or Nb==1) return Nb;
-	char temp[Nb*size];
-	int j = 0, i;
-	for (i=0; i<Nb-1; i++)
-		if (0!=Compar((char*)Array+i*size, (char*)Array+(i+1)*size))
-			memcpy(temp+j++*size, (char*)Array+i*size, size);
-	memcpy(temp+j++*size, (char*)Array+(Nb-1)*size, size);
 
-	for (i=0; i<j; i++)
-		memcpy(Array, temp, j*size);
+#define CATALOG_MAGIC "N2CAT001"
+static __thread int IgnoreCatalog=0;	// While updating it
 
-	return j;
+static void FreeCatalog(tCatalog *Cat) {
+	if (Cat==NULL) return;
+	if (Cat->Subs) for (int i=0; i<Cat->NbSubs; i++) free(Cat->Subs[i]);
+	free(Cat->Subs); free(Cat->Entries); free(Cat);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
-/// HIFN	Look for an item in an array
-/// HIFN	Compar / Comparision function
-/// HIRET	1 if item is found in (unsorted) array
+/// HIFN	Index of the 1st entry with a run number >= RunNo
 ///////////////////////////////////////////////////////////////////////////////
-static int FindInArray(void* Item, void* Array, int Nb, int Size, int (*Compar)(const void*,const void*)) {
-//	printf("\nEnter Item:%p, Nb:%d, Size:%d", Item, Nb, Size);
-	for (int i=0; i<Nb; i++) {
-		if (0==Compar(Item, (char*)Array+Size*i)) 
-			return 1;
+static long long CatalogFindRun(const tCatalog *Cat, int RunNo) {
+	long long Lo=0, Hi=Cat->NbEntries;
+	while (Lo<Hi) {
+		long long Mid=Lo+(Hi-Lo)/2;
+		if (Cat->Entries[Mid].RunNo<RunNo) Lo=Mid+1; else Hi=Mid;
+	}
+	return Lo;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// HIRET	NULL if missing or invalid
+///////////////////////////////////////////////////////////////////////////////
+static tCatalog* LoadCatalog(const char* PathName) {
+	FILE *F=fopen(PathName, "rb");
+	if (F==NULL) return NULL;
+	char Magic[8];
+	long long StrSize=0;
+	tCatalog *Cat=calloc(1, sizeof(tCatalog));
+	if (Cat==NULL or 1!=fread(Magic, 8, 1, F) or memcmp(Magic, CATALOG_MAGIC, 8) or
+		1!=fread(&Cat->Direct, sizeof(int), 1, F) or 1!=fread(&Cat->NbSubs, sizeof(int), 1, F) or
+		1!=fread(&Cat->NbEntries, sizeof(long long), 1, F) or 1!=fread(&StrSize, sizeof(long long), 1, F) or
+		Cat->NbSubs<0 or Cat->NbEntries<0 or StrSize<0 or StrSize>(1<<30)) goto Error;
+	
+	char *Str=malloc(StrSize+1);
+	Cat->Subs=calloc(Cat->NbSubs+1, sizeof(char*));
+	Cat->Entries=malloc((Cat->NbEntries+1)*sizeof(tCatEntry));
+	if (Str==NULL or Cat->Subs==NULL or Cat->Entries==NULL or 
+		(StrSize>0 and 1!=fread(Str, StrSize, 1, F)) or 
+		(Cat->NbEntries>0 and 1!=fread(Cat->Entries, Cat->NbEntries*sizeof(tCatEntry), 1, F))) { free(Str); goto Error; }
+	Str[StrSize]='\0';
+	char *S=Str;
+	for (int i=0; i<Cat->NbSubs; i++) {
+		if (S>=Str+StrSize or NULL==(Cat->Subs[i]=strdup(S))) { free(Str); goto Error; }
+		S+=strlen(S)+1;
+	}
+	free(Str);
+	for (long long i=0; i<Cat->NbEntries; i++) 
+		if (Cat->Entries[i].Subs>=Cat->NbSubs) goto Error;
+	fclose(F);
+	return Cat;
+
+Error:
+	SLOG(SWRN, "Invalid catalog %s", PathName);
+	fclose(F);
+	FreeCatalog(Cat);
+	return NULL;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	Write the catalog through a temporary file
+/// HIRET	-errno or 0
+///////////////////////////////////////////////////////////////////////////////
+static int SaveCatalog(const char* PathName, const tCatalog *Cat) {
+	char Tmp[PATH_MAX+16];
+	snprintf(Tmp, sizeof(Tmp), "%s.%d.tmp", PathName, (int)getpid());
+	FILE *F=fopen(Tmp, "wb");
+	if (F==NULL) { SLOG(SERR, "Cannot create %s: %s", Tmp, strerror(errno)); return -errno; }
+	long long StrSize=0;
+	for (int i=0; i<Cat->NbSubs; i++) StrSize+=strlen(Cat->Subs[i])+1;
+	long long Pad=(8-StrSize%8)%8;
+	int Ok=(1==fwrite(CATALOG_MAGIC, 8, 1, F) and 
+			1==fwrite(&Cat->Direct, sizeof(int), 1, F) and 1==fwrite(&Cat->NbSubs, sizeof(int), 1, F) and
+			1==fwrite(&Cat->NbEntries, sizeof(long long), 1, F));
+	StrSize+=Pad;
+	Ok=Ok and 1==fwrite(&StrSize, sizeof(long long), 1, F);
+	for (int i=0; Ok and i<Cat->NbSubs; i++) Ok=(1==fwrite(Cat->Subs[i], strlen(Cat->Subs[i])+1, 1, F));
+	Ok=Ok and Pad==(long long)fwrite("\0\0\0\0\0\0\0", 1, Pad, F);
+	if (Ok and Cat->NbEntries>0) Ok=(1==fwrite(Cat->Entries, Cat->NbEntries*sizeof(tCatEntry), 1, F));
+	if (fclose(F) or !Ok or rename(Tmp, PathName)) {
+		int R=-errno;
+		SLOG(SERR, "Cannot write %s: %s", PathName, strerror(errno));
+		unlink(Tmp);
+		return R;
 	}
 	return 0;
 }
 
+static long long CatalogStamp(const char* RootDirName, const tCatalog *Cat);
+static int CatalogAddNewRuns(tCatalog *Cat, const char* RootDirName, long long *Start);
+
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	Catalog of the root directory if there is one, reloaded only if the file changed. One per thread
+/// HIFN	Runs written since the last N2_UpdateCatalog() are scanned and added to the copy in memory
+/// HIPAR	RootDirName / NULL to free it
+///////////////////////////////////////////////////////////////////////////////
+static const tCatalog* GetCatalog(const char* RootDirName, int Direct) {
+	/*thread_local*/ static __thread tCatalog *Cat=NULL;
+	/*thread_local*/ static __thread char CatPath[PATH_MAX]="";
+	/*thread_local*/ static __thread struct stat CatSt;
+	/*thread_local*/ static __thread long long CatStamp;	// Directories modified after this are scanned again
+	if (RootDirName==NULL) { FreeCatalog(Cat); Cat=NULL; CatPath[0]='\0'; return NULL; }
+	if (IgnoreCatalog) return NULL;
+	
+	char Path[PATH_MAX];
+	struct stat St;
+	snprintf(Path, sizeof(Path), "%s/" CATALOG_NAME, RootDirName);
+	int SaveErrno=errno;
+	if (stat(Path, &St)) { errno=SaveErrno; return NULL; }	// No catalog, scan the directories
+	if (Cat==NULL or strcmp(Path, CatPath) or St.st_ino!=CatSt.st_ino or St.st_size!=CatSt.st_size or 
+		St.st_mtim.tv_sec!=CatSt.st_mtim.tv_sec or St.st_mtim.tv_nsec!=CatSt.st_mtim.tv_nsec) {
+		FreeCatalog(Cat);
+		Cat=LoadCatalog(Path);
+		strcpy(CatPath, Path); CatSt=St;
+		CatStamp=St.st_ctim.tv_sec*1000000000LL+St.st_ctim.tv_nsec;	// Renamed in the root at that time
+	}
+	if (Cat and Cat->Direct==Direct and CatalogStamp(RootDirName, Cat)>CatStamp) {
+		SLOG(SDBG, "%s modified since %s", RootDirName, CATALOG_NAME);
+		if (CatalogAddNewRuns(Cat, RootDirName, &CatStamp)<0) { FreeCatalog(Cat); Cat=NULL; CatPath[0]='\0'; }
+		else CatStamp--;	// Files written in the same tick as the start of the scan are looked for again
+	}
+	errno=SaveErrno;
+	return (Cat and Cat->Direct==Direct ? Cat : NULL);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	Order of the file names. The subsystems must be sorted first, see SortCatalog()
+///////////////////////////////////////////////////////////////////////////////
+static int CompareCatEntries(const void *A, const void *B) {
+	const tCatEntry *a=A, *b=B;
+	if (a->RunNo  !=b->RunNo  ) return a->RunNo  <b->RunNo   ? -1 : 1;
+	if (a->CycNo  !=b->CycNo  ) return a->CycNo  <b->CycNo   ? -1 : 1;
+	if (a->SizeIdx!=b->SizeIdx) return a->SizeIdx<b->SizeIdx ? -1 : 1;
+	if (a->Subs   !=b->Subs   ) return a->Subs   -b->Subs;
+	return a->HdrVer-b->HdrVer;
+}
 
+static int CompareStrPtr(const void *A, const void *B) { 
+	return strcmp(*(char**)A, *(char**)B);
+}
 
 ///////////////////////////////////////////////////////////////////////////////
-/// HIFN	Find the run numbers available in a given directory
-/// HIPAR	Direct / 0: Look for directories names /RunNo/1000/RunNo%1000/ in RootDirName
-/// HIPAR	Direct / 1: Look for files named RunNo_... in RootDirName
-/// HIPAR	RunNoList / Returned array of RunNo, passed by reference, 
-/// HIPAR	RunNoList / initially NULL, you should free it at the end of the prog, otherwise it's reused
-/// HIPAR	StartFromRunNo / Start search from this run (0 by default) to speed cache refresh
-/// HIRET	Number of runs found (or -errno)
+/// HIFN	Sort the subsystem names, then the entries like the file names
+/// HIRET	-errno or 0
 ///////////////////////////////////////////////////////////////////////////////
-int N2_GetRunNumbers(const char* RootDirName, int Direct, int *RunNoList[], 
-					 const int StartFromRunNo) {
+static int SortCatalog(tCatalog *Cat) {
+	char **Old=malloc((Cat->NbSubs+1)*sizeof(char*));
+	int *Rank=malloc((Cat->NbSubs+1)*sizeof(int));
+	if (Old==NULL or Rank==NULL) { free(Old); free(Rank); return -(errno=ENOMEM); }
+	memcpy(Old, Cat->Subs, Cat->NbSubs*sizeof(char*));
+	qsort(Cat->Subs, Cat->NbSubs, sizeof(char*), CompareStrPtr);
+	for (int i=0; i<Cat->NbSubs; i++)	// Names are unique, so the pointers are too
+		for (int j=0; j<Cat->NbSubs; j++) 
+			if (Cat->Subs[j]==Old[i]) { Rank[i]=j; break; }
+	for (long long i=0; i<Cat->NbEntries; i++) 
+		if (Cat->Entries[i].Subs>=0) Cat->Entries[i].Subs=Rank[Cat->Entries[i].Subs];
+	free(Old); free(Rank);
+	qsort(Cat->Entries, Cat->NbEntries, sizeof(tCatEntry), CompareCatEntries);
+	return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	Add the header files of a directory to the catalog
+/// HIPAR	OnlyRun / Keep only this run, or -1 for all the runs >= MinRun
+/// HIPAR	Size / Allocated size of Cat->Entries, updated
+/// HIRET	-errno or number of entries added
+///////////////////////////////////////////////////////////////////////////////
+static int CatalogScanDir(tCatalog *Cat, long long *Size, const char* DirPath, int OnlyRun, int MinRun) {
+	DIR *D=opendir(DirPath);
+	if (D==NULL) { SLOG(SERR, "Cannot open %s: %s", DirPath, strerror(errno)); return -errno; }
+	tN2data N2data={0};
+	N2data.UseArena=1;	// Reused for every header
 	int Nb=0;
-	//	SLOG(SDBG, "Enter");
+	for (struct dirent *E; (E=readdir(D)); ) {
+		int Rn, Cn, Si, Hv;
+		char SubS[N2_SUBS_MAX];
+		if (!(strlen(E->d_name)>22 and MatchHeaderName(E->d_name, &Rn, &Cn, &Si, SubS, &Hv) and 
+			  (OnlyRun<0 ? Rn>=MinRun : Rn==OnlyRun))) continue;
+		
+		int S=0;
+		while (S<Cat->NbSubs and strcmp(Cat->Subs[S], SubS)) S++;
+		if (S==Cat->NbSubs) {
+			char **Subs=realloc(Cat->Subs, (S+1)*sizeof(char*));
+			if (Subs==NULL) goto NoMem;
+			Cat->Subs=Subs;
+			if (NULL==(Cat->Subs[S]=strdup(SubS))) goto NoMem;
+			Cat->NbSubs++;
+		}
+		if (Cat->NbEntries==*Size) {
+			tCatEntry *Entries=realloc(Cat->Entries, (*Size=2*(*Size)+1024)*sizeof(tCatEntry));
+			if (Entries==NULL) goto NoMem;
+			Cat->Entries=Entries;
+		}
+		
+		// Content of the header and size of the data file
+		tCatEntry *C=&Cat->Entries[Cat->NbEntries++];
+		*C=(tCatEntry){ .RunNo=Rn, .CycNo=Cn, .SizeIdx=Si, .HdrVer=Hv, .Subs=S };
+		char Path[PATH_MAX];
+		snprintf(Path, sizeof(Path), "%s/%s", DirPath, E->d_name);
+		struct stat St;
+		if (N2_ReadConfig(Path, &N2data, 1)<0) C->NbRow=(errno ? -errno : -ENOENT);
+		else if (stat(ConfigToDataName(Path), &St)) C->NbRow=-errno;
+		else {
+			C->NbCol=N2data.NbCol; C->FirstTimeStamp=N2data.FirstTimeStamp; C->LastTimeStamp=N2data.LastTimeStamp;
+			C->NbRow=St.st_size/((N2data.NbCol+1)*8);
+		}
+		Nb++;
+	}
+	closedir(D);
+	N2_ClearConfig(&N2data);
 	errno=0;
-	//	if (*RunNoList) free(*RunNoList);
-	//	*RunNoList=calloc(DEF_ALLOC, sizeof(int));	// Max size with 3 digits
-	*RunNoList=realloc(*RunNoList, DEF_ALLOC*sizeof(int));	// Max size with 6 digits (direct) or 3 (indirect)
-	if (*RunNoList==NULL) return -(errno=ENOMEM);
+	return Nb;
+
+NoMem:
+	closedir(D);
+	N2_ClearConfig(&N2data);
+	return -(errno=ENOMEM);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	Newest mtime (ns) of the directories where the headers not in the catalog would appear: 
+/// HIFN	the root directory, and the thousands and run directories of the last run
+///////////////////////////////////////////////////////////////////////////////
+static long long CatalogStamp(const char* RootDirName, const tCatalog *Cat) {
+	int RunNo=(Cat->NbEntries ? Cat->Entries[Cat->NbEntries-1].RunNo : -1);
+	long long Stamp=0;
+	for (int Level=0; Level<(Cat->Direct or RunNo<0 ? 1 : 3); Level++) {
+		char DirPath[PATH_MAX];
+		struct stat St;
+		if      (Level==0) snprintf(DirPath, sizeof(DirPath), "%s",           RootDirName);
+		else if (Level==1) snprintf(DirPath, sizeof(DirPath), "%s/%03i",      RootDirName, RunNo/1000);
+		else               snprintf(DirPath, sizeof(DirPath), "%s/%03i/%03i", RootDirName, RunNo/1000, RunNo%1000);
+		if (0==stat(DirPath, &St) and St.st_mtim.tv_sec*1000000000LL+St.st_mtim.tv_nsec>Stamp) 
+			Stamp=St.st_mtim.tv_sec*1000000000LL+St.st_mtim.tv_nsec;
+	}
+	return Stamp;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	Scan the runs from the last one in the catalog onwards, the previous ones being complete,
+/// HIFN	see StartFromRunNo in N2_GetRunNumbers(). The last run may have grown since: it is scanned again
+/// HIPAR	Start / Returned time of the start of the scan, comparable with the mtimes of CatalogStamp()
+/// HIRET	-errno or 0
+///////////////////////////////////////////////////////////////////////////////
+static int CatalogAddNewRuns(tCatalog *Cat, const char* RootDirName, long long *Start) {
+	struct timespec Now;
+	clock_gettime(CLOCK_REALTIME_COARSE, &Now);	// Like the file times, so that nothing written during the scan is newer
+	*Start=Now.tv_sec*1000000000LL+Now.tv_nsec;
+	long long Size=Cat->NbEntries;
+	int StartFromRunNo=(Cat->NbEntries ? Cat->Entries[Cat->NbEntries-1].RunNo : 0);
+	Cat->NbEntries=CatalogFindRun(Cat, StartFromRunNo);
 	
-	#pragma GCC diagnostic push
-	#pragma GCC diagnostic ignored "-Wpedantic"
-	/// HIFN	Return 1 if the name is a header file %6d_%6d_%3d_%[^.].hd
-	int FilterHeaderNames(const struct dirent* dir) {
-		int Rn=0, Cn, Si, n, nc=-1;
-		char SubS[80];
-		return strlen(dir->d_name)>22 and 
-		4==(n=sscanf(dir->d_name, "%6d_%6d_%3d_%[^.].hd%n", &Rn, &Cn, &Si, SubS, &nc)) and
-		nc!=-1 and	// This way we match only header files
-		Rn>=StartFromRunNo;
+	int R=0, *RunNoList=NULL, Ignore=IgnoreCatalog;
+	IgnoreCatalog=1;
+	int NR=N2_GetRunNumbers(RootDirName, Cat->Direct, &RunNoList, StartFromRunNo);
+	if (NR<0) R=NR;
+	else if (Cat->Direct and NR>0) R=CatalogScanDir(Cat, &Size, RootDirName, -1, StartFromRunNo);
+	else for (int i=0; i<NR and R>=0; i++) {
+		char DirPath[PATH_MAX];
+		snprintf(DirPath, sizeof(DirPath), "%s/%03i/%03i", RootDirName, RunNoList[i]/1000, RunNoList[i]%1000);
+		if ((R=CatalogScanDir(Cat, &Size, DirPath, RunNoList[i], 0))==0) {	// Keep track of empty runs
+			if (Cat->NbEntries==Size) {
+				tCatEntry *Entries=realloc(Cat->Entries, (Size=2*Size+1024)*sizeof(tCatEntry));
+				if (Entries==NULL) { R=-(errno=ENOMEM); break; }
+				Cat->Entries=Entries;
+			}
+			Cat->Entries[Cat->NbEntries++]=(tCatEntry){ .RunNo=RunNoList[i], .CycNo=-1, .Subs=-1 };
+		}
 	}
+	IgnoreCatalog=Ignore;
+	free(RunNoList);
+	return (R<0 ? R : SortCatalog(Cat));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	Create or update the catalog of a data store: the list of all the header files with their row counts and time ranges.
+/// HIFN	When it exists, N2_GetRunNumbers(), N2_GetSubsystems(), N2_GetCycleNumbers() and N2_GetMinMax*() use it
+/// HIFN	instead of scanning the directories. The runs written since are found by scanning from the last run of the catalog,
+/// HIFN	so update it from time to time to keep that short. Updating it only scans those runs too
+/// HIPAR	Rebuild / 1 to scan the whole store again
+/// HIRET	-errno or number of runs in the catalog
+///////////////////////////////////////////////////////////////////////////////
+int N2_UpdateCatalog(const char* RootDirName, int Direct, int Rebuild) {
+	SLOG(SDBG, "Enter: %s", RootDirName);
+	char Path[PATH_MAX];
+	snprintf(Path, sizeof(Path), "%s/" CATALOG_NAME, RootDirName);
+	tCatalog *Cat=(Rebuild ? NULL : LoadCatalog(Path));
+	if (Cat and Cat->Direct!=Direct) { FreeCatalog(Cat); Cat=NULL; }
+	if (Cat==NULL and NULL==(Cat=calloc(1, sizeof(tCatalog)))) return -(errno=ENOMEM);
+	Cat->Direct=Direct;
 	
-	/// HIFN	Return 1 if the string is exactly 3 digits assumed to be thousands
-	int Filter3digitsK(const struct dirent* dir) {
-		return strlen(dir->d_name)==3 and 
-		'0'<=dir->d_name[0] and dir->d_name[0]<='9' and 
-		'0'<=dir->d_name[1] and dir->d_name[1]<='9' and 
-		'0'<=dir->d_name[2] and dir->d_name[2]<='9' and
-		atoi(dir->d_name)>=StartFromRunNo/1000; 
+	int R;
+	long long Start;
+	for (int Try=0; Try<3; Try++)	// Again if the last run changed during the scan, as readers compare to the catalog time
+		if ((R=CatalogAddNewRuns(Cat, RootDirName, &Start))<0 or CatalogStamp(RootDirName, Cat)<Start) break;
+	if (R<0 or (R=SaveCatalog(Path, Cat))<0) goto End;
+	R=0;
+	for (long long i=0; i<Cat->NbEntries; i++) R+=(i==0 or Cat->Entries[i].RunNo!=Cat->Entries[i-1].RunNo);
+	SLOG(SNTC, "%d runs, %lld headers in %s", R, Cat->NbEntries, Path);
+	
+End:
+	FreeCatalog(Cat);
+	return R;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	Remove the catalog of a data store, the directories are scanned again
+///////////////////////////////////////////////////////////////////////////////
+int N2_RemoveCatalog(const char* RootDirName) {
+	char Path[PATH_MAX];
+	snprintf(Path, sizeof(Path), "%s/" CATALOG_NAME, RootDirName);
+	return unlink(Path) ? -errno : 0;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Discovery of the whole store in one pass: the thousands directories are read in parallel,
+// each thread collecting the header names of its runs. Then everything is sorted once
+// and arranged as a tree run -> subsystem -> cycle -> SizeIdx, see N2_WalkStore()
+///////////////////////////////////////////////////////////////////////////////
+
+typedef struct sWalkFile { int RunNo, CycNo, SizeIdx, Subs; } tWalkFile;	// Subs: index in the names of the thread, then global
+
+typedef struct sWalkList {
+	tWalkFile *Files;
+	long long NbFiles, Size;
+	char **Subs;				// Subsystem names
+	int NbSubs, LastSubs;
+	int Err;
+} tWalkList;
+
+typedef struct sWalkJob {
+	const char *RootDirName;
+	int Direct, StartFromRunNo;
+	int NbDirs, Next;
+	char (*Dirs)[4];			// The thousands directories
+	tWalkList *Lists;			// One per thread
+	int NbThreads, NbClaimed;
+} tWalkJob;
+
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	Add a file, or an empty run if Subs is NULL
+///////////////////////////////////////////////////////////////////////////////
+static void WalkAdd(tWalkList *L, int RunNo, int CycNo, int SizeIdx, const char* Subs) {
+	int S=-1;
+	if (Subs) {	// Usually the same as the previous one
+		if (L->NbSubs>0 and 0==strcmp(L->Subs[L->LastSubs], Subs)) S=L->LastSubs;
+		else {
+			for (S=0; S<L->NbSubs and strcmp(L->Subs[S], Subs); S++);
+			if (S==L->NbSubs) {
+				char **New=realloc(L->Subs, (S+1)*sizeof(char*));
+				if (New==NULL or NULL==(New[S]=strdup(Subs))) { if (New) L->Subs=New; L->Err=ENOMEM; return; }
+				L->Subs=New; L->NbSubs++;
+			}
+			L->LastSubs=S;
+		}
+	}
+	if (L->NbFiles==L->Size) {
+		tWalkFile *New=realloc(L->Files, (L->Size=2*L->Size+1024)*sizeof(tWalkFile));
+		if (New==NULL) { L->Err=ENOMEM; return; }
+		L->Files=New;
+	}
+	L->Files[L->NbFiles++]=(tWalkFile){ RunNo, CycNo, SizeIdx, S };
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	Add the header files of a directory
+/// HIPAR	OnlyRun / Keep only this run, or -1 for all the runs >= MinRun
+/// HIRET	Number of files added, or -errno if the directory cannot be read
+///////////////////////////////////////////////////////////////////////////////
+static int WalkDir(tWalkList *L, const char* DirPath, int OnlyRun, int MinRun) {
+	DIR *D=opendir(DirPath);
+	if (D==NULL) return -errno;
+	int Nb=0;
+	for (struct dirent *E; (E=readdir(D)) and !L->Err; ) {
+		int Rn, Cn, Si, Hv;
+		char SubS[N2_SUBS_MAX];
+		if (MatchHeaderName(E->d_name, &Rn, &Cn, &Si, SubS, &Hv) and (OnlyRun<0 ? Rn>=MinRun : Rn==OnlyRun)) {
+			WalkAdd(L, Rn, Cn, Si, SubS);
+			Nb++;
+		}
 	}
+	closedir(D);
+	return Nb;
+}
+
+static int IsNumDir(const struct dirent *E) {	// Exactly 3 digits, and not a file when the type is known
+	const char *Name=E->d_name;
+	return Name[0]>='0' and Name[0]<='9' and Name[1]>='0' and Name[1]<='9' and Name[2]>='0' and Name[2]<='9' and Name[3]=='\0' and
+		   (E->d_type==DT_DIR or E->d_type==DT_LNK or E->d_type==DT_UNKNOWN);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	Thread function: takes thousands directories until there are none left. Arg is a tWalkJob
+/// HIFN	Directories that cannot be read are skipped, the rest of the store is still useful
+///////////////////////////////////////////////////////////////////////////////
+static void* WalkThousands(void* Arg) {
+	tWalkJob *J=Arg;
+	int t=__sync_fetch_and_add(&J->NbClaimed, 1);	// Its own list
+	if (t>=J->NbThreads) return NULL;
+	tWalkList *L=&J->Lists[t];
 	
-	/// HIFN	Return 1 if the string is exactly 3 digits assumed to be units
-	int Filter3digitsU(const struct dirent* dir) {
-		return strlen(dir->d_name)==3 and 
-		'0'<=dir->d_name[0] and dir->d_name[0]<='9' and 
-		'0'<=dir->d_name[1] and dir->d_name[1]<='9' and 
-		'0'<=dir->d_name[2] and dir->d_name[2]<='9' and
-		atoi(dir->d_name)>=StartFromRunNo%1000; 
+	for (int i; (i=__sync_fetch_and_add(&J->Next, 1))<J->NbDirs and !L->Err; ) {
+		int K=atoi(J->Dirs[i]);
+		char Path[PATH_MAX];
+		snprintf(Path, sizeof(Path), "%s/%s", J->RootDirName, J->Dirs[i]);
+		DIR *D=opendir(Path);
+		if (D==NULL) { SLOG(SWRN, "Cannot open %s, skipped: %s", Path, strerror(errno)); continue; }
+		for (struct dirent *E; (E=readdir(D)) and !L->Err; ) {
+			if (!IsNumDir(E) or K*1000+atoi(E->d_name)<J->StartFromRunNo) continue;
+			int RunNo=K*1000+atoi(E->d_name);
+			char RunPath[PATH_MAX+sizeof(E->d_name)];
+			snprintf(RunPath, sizeof(RunPath), "%s/%s", Path, E->d_name);
+			int Nb=WalkDir(L, RunPath, RunNo, 0);
+			if (Nb<0) SLOG(SWRN, "Cannot open %s, skipped: %s", RunPath, strerror(-Nb));
+			else if (Nb==0 and !L->Err) WalkAdd(L, RunNo, -1, -1, NULL);	// Empty run
+		}
+		closedir(D);
 	}
-	#pragma GCC diagnostic pop
+	return NULL;
+}
+
+static __thread char **SortSubs;	// For CompareWalkFiles, qsort has no argument
+static int CompareWalkFiles(const void *A, const void *B) {
+	const tWalkFile *a=A, *b=B;
+	if (a->RunNo  !=b->RunNo  ) return a->RunNo  <b->RunNo   ? -1 : 1;
+	if (a->Subs   !=b->Subs   ) return a->Subs<0 or b->Subs<0 ? a->Subs-b->Subs : strcmp(SortSubs[a->Subs], SortSubs[b->Subs]);
+	if (a->CycNo  !=b->CycNo  ) return a->CycNo  <b->CycNo   ? -1 : 1;
+	return a->SizeIdx-b->SizeIdx;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	Find all the header files of a store in a single walk through the directories, 
+/// HIFN	and arrange them as a tree: runs, then their subsystems, then their cycles, then their SizeIdx, all sorted
+/// HIPAR	Direct / 0: RootDirName/RunNo/1000/RunNo%1000/..., whose thousands directories are read in parallel. 1: flat directory
+/// HIPAR	Tree / Result, to be freed with N2_FreeTree()
+/// HIPAR	StartFromRunNo / Ignore the runs before this one. 0 for all
+/// HIPAR	NbThreads / Number of threads for Direct=0. 0 for the number of cores
+/// HIRET	Number of runs found (or -errno)
+///////////////////////////////////////////////////////////////////////////////
+int N2_WalkStore(const char* RootDirName, int Direct, tN2tree *Tree, int StartFromRunNo, int NbThreads) {
+	SLOG(SDBG, "Enter: %s", RootDirName);
+	bzero(Tree, sizeof(tN2tree));
+	tWalkJob J={ .RootDirName=RootDirName, .Direct=Direct, .StartFromRunNo=StartFromRunNo };
+	int R=0;
 	
 	if (Direct) {
-		struct dirent **hlist;
-		int h = scandir(RootDirName, &hlist, FilterHeaderNames, alphasort);
-		if (h == -1) { perror("scandir"); return -errno; }
-		
-		for (int i=0; i<h; i++) {
-			//			printf("%s\n", hlist[i]->d_name);
-			(*RunNoList)[Nb++]=atoi(hlist[i]->d_name);
-			free(hlist[i]);
-		}
-		free(hlist);
+		J.NbThreads=1;
+		if (NULL==(J.Lists=calloc(1, sizeof(tWalkList)))) return -(errno=ENOMEM);
+		if ((R=WalkDir(&J.Lists[0], RootDirName, -1, StartFromRunNo))<0) SLOG(SERR, "Cannot open %s: %s", RootDirName, strerror(-R));
+		else R=0;
 	} else {
-		struct dirent **klist=NULL;
-		int k = scandir(RootDirName, &klist, Filter3digitsK, alphasort);
-		if (k == -1) { perror("scandir"); return -errno; }
-		
-		for (int i=0; i<k; i++) {
-			//			printf("%s\n", klist[i]->d_name);
-			
-			// Recurse 2nd level
-			struct dirent **plist=NULL;
-			int p;
-			
-			char Sub[1024];
-			sprintf(Sub, "%s/%s", RootDirName, klist[i]->d_name);
-			p = scandir(Sub, &plist, Filter3digitsU, alphasort);
-			if (p == -1) { perror("scandir2"); return -errno; }
-			
-			for (int j=0; j<p; j++) {
-				//				printf("%s/%s\n", klist[i]->d_name, plist[j]->d_name);
-				(*RunNoList)[Nb++] = atoi(klist[i]->d_name)*1000 + atoi(plist[j]->d_name);
-				free(plist[j]); plist[j]=NULL;
+		DIR *D=opendir(RootDirName);
+		if (D==NULL) { SLOG(SERR, "Cannot open %s: %s", RootDirName, strerror(errno)); return -errno; }
+		int Size=0;
+		for (struct dirent *E; (E=readdir(D)); ) {
+			if (!IsNumDir(E) or atoi(E->d_name)<StartFromRunNo/1000) continue;
+			if (J.NbDirs==Size) {
+				char (*New)[4]=realloc(J.Dirs, (Size=2*Size+64)*sizeof(*J.Dirs));
+				if (New==NULL) { R=-(errno=ENOMEM); break; }
+				J.Dirs=New;
 			}
-			free(plist);    plist   =NULL;
-			free(klist[i]); klist[i]=NULL;
+			strcpy(J.Dirs[J.NbDirs++], E->d_name);
 		}
-		free(klist); klist=NULL;
+		closedir(D);
+		if (NbThreads<=0) NbThreads=(int)sysconf(_SC_NPROCESSORS_ONLN);
+		if (NbThreads>J.NbDirs) NbThreads=J.NbDirs;
+		if (NbThreads<1) NbThreads=1;
+		J.NbThreads=NbThreads;
+		if (R==0 and NULL==(J.Lists=calloc(NbThreads, sizeof(tWalkList)))) R=-(errno=ENOMEM);
+		if (R==0) {
+			pthread_t Threads[NbThreads];
+			int Started=0;
+			for (; Started<NbThreads-1; Started++)
+				if (pthread_create(&Threads[Started], NULL, WalkThousands, &J)) break;
+			WalkThousands(&J);
+			for (int t=0; t<Started; t++) pthread_join(Threads[t], NULL);
+		}
+		free(J.Dirs);
 	}
-	// NOTE: RunNoList should already be sorted by the alphasort function
-	qsort(    *RunNoList, Nb, sizeof(int), CompareInt);	// qsort *is* thread safe if you don't use global variables in the comparision function
-	Nb=RmDups(*RunNoList, Nb, sizeof(int), CompareInt);
-	//	*RunNoList=realloc(*RunNoList, Nb*sizeof(int));		// Optional
-	//	if (*RunNoList==NULL) return -(errno=ENOMEM);
-	return errno ? -errno : Nb;
+	
+	// Merge the lists, with a global table of subsystem names
+	long long NbFiles=0;
+	for (int t=0; t<J.NbThreads and R==0; t++) {
+		if (J.Lists[t].Err>0) R=-(errno=J.Lists[t].Err);
+		NbFiles+=J.Lists[t].NbFiles;
+	}
+	tWalkFile *Files=NULL;
+	if (R==0 and NULL==(Files=malloc((NbFiles+1)*sizeof(tWalkFile)))) R=-(errno=ENOMEM);
+	NbFiles=0;
+	for (int t=0; t<J.NbThreads and R==0; t++) {
+		tWalkList *L=&J.Lists[t];
+		int Map[L->NbSubs+1];
+		for (int s=0; s<L->NbSubs and R==0; s++) {
+			int g=0;
+			for (; g<Tree->NbSubsystems and strcmp(Tree->Subsystems[g], L->Subs[s]); g++);
+			if (g==Tree->NbSubsystems) {
+				char **New=realloc(Tree->Subsystems, (g+1)*sizeof(char*));
+				if (New==NULL) { R=-(errno=ENOMEM); break; }
+				Tree->Subsystems=New;
+				New[g]=L->Subs[s]; L->Subs[s]=NULL;	// Moved
+				Tree->NbSubsystems++;
+			}
+			Map[s]=g;
+		}
+		for (long long i=0; i<L->NbFiles and R==0; i++) {
+			Files[NbFiles]=L->Files[i];
+			if (Files[NbFiles].Subs>=0) Files[NbFiles].Subs=Map[Files[NbFiles].Subs];
+			NbFiles++;
+		}
+	}
+	for (int t=0; t<J.NbThreads; t++) {
+		for (int s=0; s<J.Lists[t].NbSubs; s++) free(J.Lists[t].Subs[s]);
+		free(J.Lists[t].Subs); free(J.Lists[t].Files);
+	}
+	free(J.Lists);
+	if (R<0) { free(Files); N2_FreeTree(Tree); return R; }
+	
+	SortSubs=Tree->Subsystems;
+	qsort(Files, NbFiles, sizeof(tWalkFile), CompareWalkFiles);
+	
+	// Count the nodes of each level, then fill them. Every level is one array, the nodes point inside the next one
+	long long NbSubs=0, NbCycs=0;
+	for (long long i=0; i<NbFiles; i++) {
+		const tWalkFile *F=&Files[i], *P=(i ? &Files[i-1] : NULL);
+		int NewRun=(P==NULL or P->RunNo!=F->RunNo), NewSubs=NewRun or P->Subs!=F->Subs;
+		Tree->NbRuns+=NewRun;
+		if (F->Subs<0) continue;
+		NbSubs+=NewSubs;
+		NbCycs+=(NewSubs or P->CycNo!=F->CycNo);
+	}
+	Tree->Runs=calloc(Tree->NbRuns+1, sizeof(tN2runNode));
+	tN2subsNode *Subs=calloc(NbSubs+1, sizeof(tN2subsNode));
+	tN2cycleNode *Cycs=calloc(NbCycs+1, sizeof(tN2cycleNode));
+	int *SizeIdx=malloc((NbFiles+1)*sizeof(int));
+	Tree->Internal[0]=Subs; Tree->Internal[1]=Cycs; Tree->Internal[2]=SizeIdx;
+	if (Tree->Runs==NULL or Subs==NULL or Cycs==NULL or SizeIdx==NULL) { free(Files); N2_FreeTree(Tree); return -(errno=ENOMEM); }
+	
+	tN2runNode *Run=NULL; tN2subsNode *S=NULL; tN2cycleNode *C=NULL;
+	for (long long i=0; i<NbFiles; i++) {
+		const tWalkFile *F=&Files[i], *P=(i ? &Files[i-1] : NULL);
+		int NewRun=(P==NULL or P->RunNo!=F->RunNo), NewSubs=NewRun or P->Subs!=F->Subs;
+		if (NewRun) { Run=(Run ? Run+1 : Tree->Runs); Run->RunNo=F->RunNo; Run->Subs=(S ? S+1 : Subs); }
+		if (F->Subs<0) continue;
+		if (NewSubs) { S=(S ? S+1 : Subs); S->Name=Tree->Subsystems[F->Subs]; S->Cycles=(C ? C+1 : Cycs); Run->NbSubs++; }
+		if (NewSubs or P->CycNo!=F->CycNo) { C=(C ? C+1 : Cycs); C->CycNo=F->CycNo; C->SizeIdx=SizeIdx+i; S->NbCycles++; }
+		SizeIdx[i]=F->SizeIdx;
+		C->NbParts++;
+	}
+	for (int r=0; r<Tree->NbRuns; r++)	// Runs without subsystems point to the next one, fix that
+		if (Tree->Runs[r].NbSubs==0) Tree->Runs[r].Subs=NULL;
+	free(Files);
+	SLOG(SNTC, "%d runs, %lld cycles, %lld files in %s", Tree->NbRuns, NbCycs, NbFiles, RootDirName);
+	return Tree->NbRuns;
+}
+
+void N2_FreeTree(tN2tree *Tree) {
+	for (int i=0; i<Tree->NbSubsystems; i++) free(Tree->Subsystems[i]);
+	free(Tree->Subsystems); free(Tree->Runs); 
+	for (int i=0; i<3; i++) free(Tree->Internal[i]);
+	bzero(Tree, sizeof(tN2tree));
 }
 
-#if 0
 ///////////////////////////////////////////////////////////////////////////////
-/// HIFN	Find the run numbers available in a given directory
-/// HIPAR	Direct / 0: Look for directories names /RunNo/1000/RunNo%1000/ in RootDirName
-/// HIPAR	Direct / 1: Look for files named RunNo_... in RootDirName
-/// HIPAR	RunNoList / Returned array of RunNo, passed by reference, 
-/// HIPAR	RunNoList / initially NULL, you should free it at the end of the prog, otherwise it's reused
+// Discovery functions with results of the exact size. Same answers as N2_GetRunNumbers(), N2_GetSubsystems() 
+// and N2_GetCycleNumbers(), but the lists grow as needed instead of taking DEF_ALLOC items each, 
+// the subsystem names are deduplicated with a hash set, and nothing is copied on the stack
 ///////////////////////////////////////////////////////////////////////////////
-int N2_GetRunNumbers_Simple(const char* RootDirName, int Direct, int *RunNoList[]) {
-	int Nb=0;
-//	SLOG(SDBG, "Enter");
-	errno=0;
-//	if (*RunNoList) free(*RunNoList);
-//	*RunNoList=calloc(DEF_ALLOC, sizeof(int));	// Max size with 3 digits
-	*RunNoList=realloc(*RunNoList, DEF_ALLOC*sizeof(int));	// Max size with 3 digits
-	if (*RunNoList==NULL) return -(errno=ENOMEM);
-	
-	if (Direct) {
-		struct dirent **hlist;
-		int h = scandir(RootDirName, &hlist, FilterHeaderNames, alphasort);
-		if (h == -1) { perror("scandir"); return -errno; }
-		
-		for (int i=0; i<h; i++) {
-//			printf("%s\n", hlist[i]->d_name);
-			(*RunNoList)[Nb++]=atoi(hlist[i]->d_name);
-			free(hlist[i]);
+
+typedef struct sIntList { int *Items; int Nb, Size; } tIntList;
+
+static int IntListAdd(tIntList *L, int Item) {
+	if (L->Nb==L->Size) {
+		int *New=realloc(L->Items, (L->Size=2*L->Size+16)*sizeof(int));
+		if (New==NULL) return -(errno=ENOMEM);
+		L->Items=New;
+	}
+	L->Items[L->Nb++]=Item;
+	return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	Sort, remove the duplicates and shrink to fit
+/// HIRET	Number of items
+///////////////////////////////////////////////////////////////////////////////
+static int IntListFinish(tIntList *L, int *List[]) {
+	if (L->Nb>1) {	// Items is NULL when nothing was found
+		qsort(L->Items, L->Nb, sizeof(int), CompareInt);
+		L->Nb=RmDups(L->Items, L->Nb, sizeof(int), CompareInt);
+	}
+	int *New=realloc(L->Items, (L->Nb ? L->Nb : 1)*sizeof(int));
+	*List=(New ? New : L->Items);
+	return L->Nb;
+}
+
+typedef struct sStrSet {
+	char **Items;				// In order of insertion
+	int Nb, Size;
+	int *Table;					// Open addressing, index+1 of the items, 0 for free
+	int TableSize;				// Power of 2
+} tStrSet;
+
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	Add a copy of the string if it isn't there yet
+/// HIRET	Index of the string in S->Items, or -errno
+///////////////////////////////////////////////////////////////////////////////
+static int StrSetAdd(tStrSet *S, const char* Str) {
+	if (2*(S->Nb+1)>S->TableSize) {	// Rehash
+		int NewSize=(S->TableSize ? 2*S->TableSize : 64);
+		int *Table=calloc(NewSize, sizeof(int));
+		if (Table==NULL) return -(errno=ENOMEM);
+		for (int i=0; i<S->Nb; i++) {
+			int j=HashStr(S->Items[i]) & (NewSize-1);
+			while (Table[j]) j=(j+1) & (NewSize-1);
+			Table[j]=i+1;
+		}
+		free(S->Table);
+		S->Table=Table; S->TableSize=NewSize;
+	}
+	int j=HashStr(Str) & (S->TableSize-1);
+	for (; S->Table[j]; j=(j+1) & (S->TableSize-1))
+		if (0==strcmp(S->Items[S->Table[j]-1], Str)) return S->Table[j]-1;
+	if (S->Nb==S->Size) {
+		char **New=realloc(S->Items, (S->Size=2*S->Size+16)*sizeof(char*));
+		if (New==NULL) return -(errno=ENOMEM);
+		S->Items=New;
+	}
+	if (NULL==(S->Items[S->Nb]=strdup(Str))) return -(errno=ENOMEM);
+	S->Table[j]=++S->Nb;
+	return S->Nb-1;
+}
+
+static void StrSetFree(tStrSet *S) {
+	for (int i=0; i<S->Nb; i++) free(S->Items[i]);
+	free(S->Items); free(S->Table);
+	bzero(S, sizeof(tStrSet));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	Sort and shrink to fit, the set gives away its strings
+/// HIRET	Number of strings
+///////////////////////////////////////////////////////////////////////////////
+static int StrSetFinish(tStrSet *S, char **List[]) {
+	if (S->Nb>1) qsort(S->Items, S->Nb, sizeof(char*), CompareStrPtr);
+	char **New=realloc(S->Items, (S->Nb ? S->Nb : 1)*sizeof(char*));
+	*List=(New ? New : S->Items);
+	free(S->Table);
+	return S->Nb;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	Free a list of strings returned by N2_FindSubsystems(), and the list itself
+///////////////////////////////////////////////////////////////////////////////
+void N2_FreeStrings(int N, char *List[]) {
+	if (List==NULL) return;
+	for (int i=0; i<N; i++) free(List[i]);
+	free(List);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	Find the run numbers available in a given directory, like N2_GetRunNumbers()
+/// HIPAR	RunNoList / Returned array of exactly the number of runs found, sorted. You should free it
+/// HIRET	Number of runs found (or -errno)
+///////////////////////////////////////////////////////////////////////////////
+int N2_FindRunNumbers(const char* RootDirName, int Direct, int StartFromRunNo, int *RunNoList[]) {
+	SLOG(SDBG, "Enter: %s", RootDirName);
+	tIntList L={0};
+	*RunNoList=NULL;
+	const tCatalog *Cat=GetCatalog(RootDirName, Direct);
+	if (Cat) {
+		for (long long i=CatalogFindRun(Cat, StartFromRunNo); i<Cat->NbEntries; i++)
+			if ((L.Nb==0 or L.Items[L.Nb-1]!=Cat->Entries[i].RunNo) and IntListAdd(&L, Cat->Entries[i].RunNo)<0) goto Error;
+		return IntListFinish(&L, RunNoList);
+	}
+	
+	DIR *D=opendir(RootDirName);
+	if (D==NULL) { SLOG(SERR, "Cannot open %s: %s", RootDirName, strerror(errno)); return -errno; }
+	int R=0;
+	for (struct dirent *E; R==0 and (E=readdir(D)); ) {
+		int Rn, Cn, Si, Hv;
+		char SubS[N2_SUBS_MAX];
+		if (Direct) {
+			if (MatchHeaderName(E->d_name, &Rn, &Cn, &Si, SubS, &Hv) and Rn>=StartFromRunNo) R=IntListAdd(&L, Rn);
+			continue;
 		}
-		free(hlist);
+		if (!IsNumDir(E) or atoi(E->d_name)<StartFromRunNo/1000) continue;
+		int K=atoi(E->d_name);
+		char Path[PATH_MAX];
+		snprintf(Path, sizeof(Path), "%s/%s", RootDirName, E->d_name);
+		DIR *DK=opendir(Path);
+		if (DK==NULL) { SLOG(SWRN, "Cannot open %s, skipped: %s", Path, strerror(errno)); continue; }	// Like N2_WalkStore()
+		for (struct dirent *EK; R==0 and (EK=readdir(DK)); )
+			if (IsNumDir(EK) and K*1000+atoi(EK->d_name)>=StartFromRunNo) R=IntListAdd(&L, K*1000+atoi(EK->d_name));
+		closedir(DK);
+	}
+	closedir(D);
+	if (R<0) { free(L.Items); return R; }
+	return IntListFinish(&L, RunNoList);
+
+Error:
+	free(L.Items);
+	return -errno;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	Find the subsystems available for a given run, like N2_GetSubsystems()
+/// HIPAR	SubsList / Returned array of exactly the number of subsystems found, sorted. Free it with N2_FreeStrings()
+/// HIRET	Number of subsystems found (or -errno)
+///////////////////////////////////////////////////////////////////////////////
+int N2_FindSubsystems(const char* RootDirName, int Direct, int RunNo, char **SubsList[]) {
+	SLOG(SDBG, "Enter: %s %d", RootDirName, RunNo);
+	tStrSet S={0};
+	int R=0;
+	*SubsList=NULL;
+	const tCatalog *Cat=GetCatalog(RootDirName, Direct);
+	if (Cat) {
+		for (long long i=CatalogFindRun(Cat, RunNo); i<Cat->NbEntries and Cat->Entries[i].RunNo==RunNo and R>=0; i++)
+			if (Cat->Entries[i].Subs>=0) R=StrSetAdd(&S, Cat->Subs[Cat->Entries[i].Subs]);
 	} else {
-		struct dirent **klist=NULL;
-		int k = scandir(RootDirName, &klist, Filter3digits, alphasort);
-		if (k == -1) { perror("scandir"); return -errno; }
-		
-		for (int i=0; i<k; i++) {
-//			printf("%s\n", klist[i]->d_name);
-			
-			// Recurse 2nd level
-			struct dirent **plist=NULL;
-			int p;
-			
-			char Sub[1024];
-			sprintf(Sub, "%s/%s", RootDirName, klist[i]->d_name);
-			p = scandir(Sub, &plist, Filter3digits, alphasort);
-			if (p == -1) { perror("scandir2"); return -errno; }
-			
-			for (int j=0; j<p; j++) {
-//				printf("%s/%s\n", klist[i]->d_name, plist[j]->d_name);
-				(*RunNoList)[Nb++] = atoi(klist[i]->d_name)*1000 + atoi(plist[j]->d_name);
-				free(plist[j]); plist[j]=NULL;
-			}
-			free(plist);    plist   =NULL;
-			
-			free(klist[i]); klist[i]=NULL;
+		char DirPath[PATH_MAX];
+		if (Direct) snprintf(DirPath, sizeof(DirPath), "%s",           RootDirName);
+		else        snprintf(DirPath, sizeof(DirPath), "%s/%03i/%03i", RootDirName, RunNo/1000, RunNo%1000);
+		DIR *D=opendir(DirPath);
+		if (D==NULL) { SLOG(SERR, "Cannot open %s: %s", DirPath, strerror(errno)); return -errno; }
+		for (struct dirent *E; (E=readdir(D)) and R>=0; ) {
+			int Rn, Cn, Si, Hv;
+			char SubS[N2_SUBS_MAX];
+			if (MatchHeaderName(E->d_name, &Rn, &Cn, &Si, SubS, &Hv) and Rn==RunNo) R=StrSetAdd(&S, SubS);
 		}
-		free(klist); klist=NULL;
+		closedir(D);
 	}
-	// NOTE: RunNoList should already be sorted by the alphasort function
-	qsort(    *RunNoList, Nb, sizeof(int), CompareInt);	// qsort *is* thread safe if you don't use global variables in the comparision function
-	Nb=RmDups(*RunNoList, Nb, sizeof(int), CompareInt);
-//	*RunNoList=realloc(*RunNoList, Nb*sizeof(int));		// Optional
-//	if (*RunNoList==NULL) return -(errno=ENOMEM);
-	return errno ? -errno : Nb;
+	if (R<0) { StrSetFree(&S); return R; }
+	return StrSetFinish(&S, SubsList);
 }
-#endif
 
 ///////////////////////////////////////////////////////////////////////////////
-/// HIFN	Find the subsystems available in a certain directory for a given run number
-/// HIPAR	SubsList / Returned array of CycNo, passed by reference, initially NULL, 
-/// HIPAR	SubsList / you should free it and free every substring (function will not clean it for you on re-entry)
-/// HIRET	Number of Subsystems in the SubsList array, or -errno
+/// HIFN	Find the cycle numbers available for a given run number and subsystem, like N2_GetCycleNumbers()
+/// HIPAR	CycNoList / Returned array of exactly the number of cycles found, sorted. You should free it
+/// HIRET	Number of cycles found (or -errno)
 ///////////////////////////////////////////////////////////////////////////////
-int N2_GetSubsystems(const char* RootDirName, int Direct, int RunNo, char **SubsList[]) {
-	int Nb=0;
-	SLOG(SDBG, "Enter");
-	errno=0;
-//	if (*SubsList) SLOG(SWRN, "SubsList is not NULL");
-//	*SubsList=calloc(DEF_ALLOC, sizeof(char*));	/// How many ? Probably not very many total, but temporary ?
-	*SubsList=realloc(*SubsList, DEF_ALLOC*sizeof(char*));	/// How many ? Probably not very many total, but temporary ?
-	if (*SubsList==NULL) { SLOG(SERR, "Out of memory"); return -(errno=ENOMEM); }
-	
-	#pragma GCC diagnostic push
-	#pragma GCC diagnostic ignored "-Wpedantic"
-	/// HIFN	Return 1 if the name is a header file %6d_%6d_%3d_%[^.].hd matching RunNo
-	int FilterHeaderNamesForR(const struct dirent* dir) {
-		int Rn, Cn, Si, n, nc=-1;
-		char SubS[80], *P;
-		if (!(strlen(dir->d_name)>22 and 
-			4==(n=sscanf(dir->d_name, "%6d_%6d_%3d_%[^.].hd%n", &Rn, &Cn, &Si, SubS, &nc)) and
-			nc!=-1 and	// This way we match only header files
-			Rn==RunNo))	// Only match wanted runnumber
-			return 0;
-		if (NULL==(P=strrchr(SubS, '_'))) return 0;
-		*P='\0';	// Because SubS is like coils_000 or some_other_stuff_000
-		if (!FindInArray(SubS, *SubsList, Nb, sizeof(char*), CompareStr)) {
-			(*SubsList)[Nb]=strdup(SubS);	// NOTE: Use N2_FreeSubsystems() to free cleanly
-			//					SLOG(SDBG, "Added: %s", SubS);
-			if ((*SubsList)[Nb]==NULL) SLOG(SERR, "Out of memory"); 
-			Nb++;
-			return 1;
-		} 
-		return 0;
+int N2_FindCycleNumbers(const char* RootDirName, int Direct, int RunNo, const char* Subsystem, int *CycNoList[]) {
+	SLOG(SDBG, "Enter: %s %d %s", RootDirName, RunNo, Subsystem);
+	tIntList L={0};
+	*CycNoList=NULL;
+	const tCatalog *Cat=GetCatalog(RootDirName, Direct);
+	if (Cat) {
+		for (long long i=CatalogFindRun(Cat, RunNo); i<Cat->NbEntries and Cat->Entries[i].RunNo==RunNo; i++) {
+			const tCatEntry *E=&Cat->Entries[i];
+			if (E->Subs>=0 and 0==strcmp(Cat->Subs[E->Subs], Subsystem) and IntListAdd(&L, E->CycNo)<0) { free(L.Items); return -errno; }
+		}
+		return IntListFinish(&L, CycNoList);
 	}
-	#pragma GCC diagnostic pop
 	
 	char DirPath[PATH_MAX];
-	if (Direct) sprintf(DirPath, "%s",           RootDirName);
-	else        sprintf(DirPath, "%s/%03i/%03i", RootDirName, RunNo/1000, RunNo%1000);
-	
-	struct dirent **hlist;
-	int h = scandir(DirPath, &hlist, FilterHeaderNamesForR, alphasort);
-	if (h == -1) { perror("scandir"); return -errno; }
-	
-	for (int i=0; i<h; i++) // SubsList already filled by Filter function
-		free(hlist[i]);
-	free(hlist);
-	
-	//	qsort(    *SubsList, Nb, sizeof(int), (int (*)(const void*,const void*))strcmp);
-	//	Nb=RmDups(*SubsList, Nb, sizeof(int), (int (*)(const void*,const void*))strcmp);
-	//	*SubsList=realloc(*SubsList, Nb*sizeof(char*));	// Optional
-	if (errno) SLOG(SERR, "errno %d", errno); 
-	if (Nb==0) SLOG(SWRN, "No match in %s", DirPath);
-	return errno ? -errno : Nb;
+	if (Direct) snprintf(DirPath, sizeof(DirPath), "%s",           RootDirName);
+	else        snprintf(DirPath, sizeof(DirPath), "%s/%03i/%03i", RootDirName, RunNo/1000, RunNo%1000);
+	DIR *D=opendir(DirPath);
+	if (D==NULL) { SLOG(SERR, "Cannot open %s: %s", DirPath, strerror(errno)); return -errno; }
+	int R=0;
+	for (struct dirent *E; (E=readdir(D)) and R==0; ) {
+		int Rn, Cn, Si, Hv;
+		char SubS[N2_SUBS_MAX];
+		if (MatchHeaderName(E->d_name, &Rn, &Cn, &Si, SubS, &Hv) and Rn==RunNo and 0==strcmp(SubS, Subsystem)) 
+			R=IntListAdd(&L, Cn);
+	}
+	closedir(D);
+	if (R<0) { free(L.Items); return R; }
+	return IntListFinish(&L, CycNoList);
 }
 
-void N2_FreeSubsystems(int N, char *SubsList[]) {
-	if (SubsList==NULL or *SubsList==NULL) return;
-	for (int i=0; i<N; i++) free(SubsList[i]);
-//	free(*SubsList); *SubsList=NULL;
+///////////////////////////////////////////////////////////////////////////////
+// Watch of a LiveData directory (Direct=1) with inotify. The headers present are kept in memory, 
+// sorted by RunNo, CycNo, SizeIdx, subsystem, so the N2_Watch* queries never touch the disk
+///////////////////////////////////////////////////////////////////////////////
+
+typedef struct sWatchEntry { int RunNo, CycNo, SizeIdx, Subs; } tWatchEntry;
+
+struct sN2watch {
+	int Fd, Wd;
+	char *DirName;
+	tStrSet Subs;				// All the subsystem names seen, Entries[].Subs indexes them
+	tWatchEntry *Entries;
+	long long NbEntries, Size;
+	int BufLen, BufPos;			// Events read but not returned yet
+	char Buf[64*1024] __attribute__((aligned(__alignof__(struct inotify_event))));
+};
+
+static int CompareWatchEntries(const tWatchEntry *A, const tWatchEntry *B) {
+	if (A->RunNo  !=B->RunNo)   return A->RunNo  <B->RunNo   ? -1 : 1;
+	if (A->CycNo  !=B->CycNo)   return A->CycNo  <B->CycNo   ? -1 : 1;
+	if (A->SizeIdx!=B->SizeIdx) return A->SizeIdx<B->SizeIdx ? -1 : 1;
+	return A->Subs<B->Subs ? -1 : A->Subs>B->Subs;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
-/// HIFN	Find the cycle numbers available in a directory for for a given run number and subsystem 
-/// HIPAR	CycNoList / Returned array of CycNo, passed by reference, initially NULL, you should free it, or give it again to the function which will free it
+/// HIFN	Position of an entry, or of the first entry after it (to find runs, use CycNo=SizeIdx=Subs=-1)
 ///////////////////////////////////////////////////////////////////////////////
-int N2_GetCycleNumbers(const char* RootDirName, int Direct, int RunNo, const char* Subsystem, int *CycNoList[]) {
-	int Nb=0;
-	char DirPath[PATH_MAX];
-	SLOG(SDBG, "Enter R=%d %s\n", RunNo, Subsystem);
-	errno=0;
-//	if (*CycNoList) free(*CycNoList);
-//	*CycNoList=calloc(DEF_ALLOC, sizeof(int));	// Max size with 6 digits - FIXME: that's 6 digits here
-	*CycNoList=realloc(*CycNoList, DEF_ALLOC*sizeof(int));	// Max size with 6 digits - FIXME: that's 6 digits here
-	if (*CycNoList==NULL) { SLOG(SERR, "Out of memory"); return -(errno=ENOMEM); }
+static long long WatchFind(const tN2watch *W, const tWatchEntry *E) {
+	long long Lo=0, Hi=W->NbEntries;
+	while (Lo<Hi) {
+		long long Mid=Lo+(Hi-Lo)/2;
+		if (CompareWatchEntries(&W->Entries[Mid], E)<0) Lo=Mid+1; else Hi=Mid;
+	}
+	return Lo;
+}
 
-	#pragma GCC diagnostic push
-	#pragma GCC diagnostic ignored "-Wpedantic"
-	/// HIFN	Return 1 if the name is a header file %6d_%6d_%3d_%[^.].hd
-	int FilterHeaderNamesForRandS(const struct dirent* dir) {
-		int Rn, Cn, Si, n, nc=-1;
-		char SubS[80], *P;
-		int Res=(strlen(dir->d_name)>22 and 
-				4==(n=sscanf(dir->d_name, "%6d_%6d_%3d_%[^.].hd%n", &Rn, &Cn, &Si, SubS, &nc)) and
-				nc!=-1 and	// This way we match only header files
-				Rn==RunNo);	// Only match wanted runnumber
-		if (!Res) return 0;
-		if (NULL==(P=strrchr(SubS, '_'))) return 0;
-		*P='\0';	// Because SubS is like coils_000 or some_other_stuff_000
-		if (strcmp(Subsystem, SubS)==0) { (*CycNoList)[Nb++]=Cn; return 1; }	// There will be duplicates
-		return 0;
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	Add or remove a header in the list kept in memory
+/// HIRET	-errno or 0
+///////////////////////////////////////////////////////////////////////////////
+static int WatchUpdate(tN2watch *W, int Add, int RunNo, int CycNo, int SizeIdx, const char* Subs) {
+	int S=StrSetAdd(&W->Subs, Subs);
+	if (S<0) return S;
+	tWatchEntry E={RunNo, CycNo, SizeIdx, S};
+
+	long long i=WatchFind(W, &E);
+	int There=(i<W->NbEntries and 0==CompareWatchEntries(&W->Entries[i], &E));
+	if (Add and not There) {
+		if (W->NbEntries==W->Size) {
+			tWatchEntry *New=realloc(W->Entries, (W->Size=2*W->Size+64)*sizeof(tWatchEntry));
+			if (New==NULL) return -(errno=ENOMEM);
+			W->Entries=New;
+		}	// New runs come at the end, so this is usually no move at all
+		memmove(W->Entries+i+1, W->Entries+i, (W->NbEntries-i)*sizeof(tWatchEntry));
+		W->Entries[i]=E;
+		W->NbEntries++;
+	} else if (not Add and There) {
+		memmove(W->Entries+i, W->Entries+i+1, (W->NbEntries-i-1)*sizeof(tWatchEntry));
+		W->NbEntries--;
 	}
-	#pragma GCC diagnostic pop
+	return 0;
+}
 
-	if (Direct) sprintf(DirPath, "%s",           RootDirName);
-	else        sprintf(DirPath, "%s/%03i/%03i", RootDirName, RunNo/1000, RunNo%1000);
-	
-	struct dirent **hlist;
-	int h = scandir(DirPath, &hlist, FilterHeaderNamesForRandS, alphasort);
-	if (h == -1) { perror("scandir"); return -errno; }
-	
-	if (Nb==0) SLOG(SWRN, "No match in %s", DirPath); 
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	Fill the list kept in memory from the directory content
+/// HIRET	-errno or 0
+///////////////////////////////////////////////////////////////////////////////
+static int WatchScan(tN2watch *W) {
+	DIR *D=opendir(W->DirName);
+	if (D==NULL) { SLOG(SERR, "Cannot open %s: %s", W->DirName, strerror(errno)); return -errno; }
+	W->NbEntries=0;
+	int R=0;
+	for (struct dirent *E; R==0 and (E=readdir(D)); ) {
+		int Rn, Cn, Si, Hv;
+		char SubS[N2_SUBS_MAX];
+		if (MatchHeaderName(E->d_name, &Rn, &Cn, &Si, SubS, &Hv)) R=WatchUpdate(W, 1, Rn, Cn, Si, SubS);
+	}
+	closedir(D);
+	return R;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	Start watching a LiveData directory (layout Direct=1) for new headers and data files
+/// HIRET	The watch, to give to N2_ReadWatch() and to the N2_Watch* queries, or NULL (and errno)
+///////////////////////////////////////////////////////////////////////////////
+tN2watch* N2_OpenWatch(const char* DirName) {
+	SLOG(SDBG, "Enter: %s", DirName);
+	tN2watch *W=calloc(1, sizeof(tN2watch));
+	if (W==NULL) { errno=ENOMEM; return NULL; }
+	W->Fd=-1;
+	if (NULL==(W->DirName=strdup(DirName))) { errno=ENOMEM; goto Error; }
+	if ((W->Fd=inotify_init1(IN_NONBLOCK|IN_CLOEXEC))<0) {
+		SLOG(SERR, "inotify_init1: %s", strerror(errno)); goto Error;
+	}
+	// Watch before the scan so nothing falls in between. Seeing a file twice is harmless
+	if ((W->Wd=inotify_add_watch(W->Fd, DirName, IN_CREATE|IN_CLOSE_WRITE|IN_MOVED_TO|IN_DELETE|IN_MOVED_FROM|IN_ONLYDIR))<0) {
+		SLOG(SERR, "Cannot watch %s: %s", DirName, strerror(errno)); goto Error;
+	}
+	if (WatchScan(W)<0) goto Error;
+	SLOG(SNTC, "Watching %s, %lld headers", DirName, W->NbEntries);
+	return W;
+
+Error:;
+	int Err=errno;
+	N2_CloseWatch(W);
+	errno=Err;
+	return NULL;
+}
+
+void N2_CloseWatch(tN2watch *W) {
+	if (W==NULL) return;
+	if (W->Fd>=0) close(W->Fd);
+	StrSetFree(&W->Subs);
+	free(W->Entries);
+	free(W->DirName);
+	free(W);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	File descriptor of the watch, readable when events are waiting, to use with poll() or epoll
+///////////////////////////////////////////////////////////////////////////////
+int N2_WatchFd(const tN2watch *W) {
+	return W->Fd;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	Wait for headers and data files created, closed after writing, or removed in the watched directory
+/// HIFN	The discovery results kept in memory are updated at the same time
+/// HIPAR	Events / Filled with up to MaxEvents events. Those that don't fit are kept for the next call
+/// HIPAR	TimeoutMs / -1 to wait forever, 0 to only take what is already there
+/// HIRET	Number of events (0 on timeout), or -errno
+///////////////////////////////////////////////////////////////////////////////
+int N2_ReadWatch(tN2watch *W, tN2watchEvent Events[], int MaxEvents, int TimeoutMs) {
+	struct timespec Now, End;
+	clock_gettime(CLOCK_MONOTONIC, &End);
+	long long EndMs=End.tv_sec*1000LL+End.tv_nsec/1000000+TimeoutMs;
+	int N=0;
 	
-	for (int i=0; i<h; i++) free(hlist[i]);
-	free(hlist);
+	while (N<MaxEvents) {
+		if (W->BufPos>=W->BufLen) {
+			if (N>0) break;
+			int Wait=TimeoutMs;
+			if (TimeoutMs>0) {
+				clock_gettime(CLOCK_MONOTONIC, &Now);
+				long long Left=EndMs-(Now.tv_sec*1000LL+Now.tv_nsec/1000000);
+				Wait=(Left>0 ? (int)Left : 0);
+			}
+			struct pollfd P={ .fd=W->Fd, .events=POLLIN };
+			int R=poll(&P, 1, Wait);
+			if (R<0 and errno==EINTR) continue;
+			if (R<0) { SLOG(SERR, "poll: %s", strerror(errno)); return -errno; }
+			if (R==0) break;	// Timeout
+			ssize_t Len=read(W->Fd, W->Buf, sizeof(W->Buf));
+			if (Len<0 and (errno==EAGAIN or errno==EINTR)) continue;
+			if (Len<0) { SLOG(SERR, "Reading events of %s: %s", W->DirName, strerror(errno)); return -errno; }
+			W->BufLen=Len; W->BufPos=0;
+		}
+		
+		const struct inotify_event *IE=(const struct inotify_event*)(W->Buf+W->BufPos);
+		W->BufPos+=sizeof(struct inotify_event)+IE->len;
+		tN2watchEvent *Ev=&Events[N];
+		
+		if (IE->mask & IN_Q_OVERFLOW) {	// Events were lost, start again from the directory content
+			SLOG(SWRN, "Too many events on %s, rescanning", W->DirName);
+			int R=WatchScan(W);
+			if (R<0) return R;
+			bzero(Ev, sizeof(tN2watchEvent));
+			Ev->What=N2_WATCH_OVERFLOW;
+			N++;
+			continue;
+		}
+		if (IE->mask & IN_IGNORED) {
+			SLOG(SWRN, "%s is not watched anymore", W->DirName);
+			return -(errno=ENOENT);
+		}
+		if (IE->len==0 or (IE->mask & IN_ISDIR)) continue;
+		
+		int Hv=0;
+		if      (MatchHeaderName(IE->name, &Ev->RunNo, &Ev->CycNo, &Ev->SizeIdx, Ev->Subsystem, &Hv)) Ev->IsHeader=1;
+		else if (MatchDataName  (IE->name, &Ev->RunNo, &Ev->CycNo, &Ev->SizeIdx, Ev->Subsystem))      Ev->IsHeader=0;
+		else continue;
+		Ev->HdrVer=Hv;
+		Ev->What=(IE->mask & IN_CREATE       ? N2_WATCH_CREATED :
+				  IE->mask & (IN_DELETE|IN_MOVED_FROM) ? N2_WATCH_REMOVED : N2_WATCH_CLOSED);	// IN_MOVED_TO is a complete file
+		if (Ev->IsHeader) {
+			int R=WatchUpdate(W, Ev->What!=N2_WATCH_REMOVED, Ev->RunNo, Ev->CycNo, Ev->SizeIdx, Ev->Subsystem);
+			if (R<0) return R;
+		}
+		N++;
+	}
+	return N;
+}
 
-	// NOTE: CycNoList should already be sorted by the alphasort function
-	qsort(    *CycNoList, Nb, sizeof(int), CompareInt);
-	Nb=RmDups(*CycNoList, Nb, sizeof(int), CompareInt);
-	//	*CycNoList=realloc(*CycNoList, Nb*sizeof(int));	// Optional
-	//	if (*CycNoList==NULL) return -(errno=ENOMEM);
-	if (errno) SLOG(SERR, "errno %d", errno);
-	if (Nb==0) SLOG(SWRN, "No match in %s for %s", DirPath, Subsystem);
-	return errno ? -errno : Nb;
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	Same as N2_FindRunNumbers() from what the watch knows, without reading the directory
+///////////////////////////////////////////////////////////////////////////////
+int N2_WatchRunNumbers(const tN2watch *W, int StartFromRunNo, int *RunNoList[]) {
+	tIntList L={0};
+	tWatchEntry Key={StartFromRunNo, -1, -1, -1};
+	for (long long i=WatchFind(W, &Key); i<W->NbEntries; i++)
+		if ((L.Nb==0 or L.Items[L.Nb-1]!=W->Entries[i].RunNo) and IntListAdd(&L, W->Entries[i].RunNo)<0) { free(L.Items); return -errno; }
+	return IntListFinish(&L, RunNoList);
 }
 
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	Same as N2_FindSubsystems() from what the watch knows. Free the list with N2_FreeStrings()
+///////////////////////////////////////////////////////////////////////////////
+int N2_WatchSubsystems(const tN2watch *W, int RunNo, char **SubsList[]) {
+	tStrSet S={0};
+	tWatchEntry Key={RunNo, -1, -1, -1};
+	for (long long i=WatchFind(W, &Key); i<W->NbEntries and W->Entries[i].RunNo==RunNo; i++) {
+		int R=StrSetAdd(&S, W->Subs.Items[W->Entries[i].Subs]);
+		if (R<0) { StrSetFree(&S); return R; }
+	}
+	return StrSetFinish(&S, SubsList);
+}
 
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	Same as N2_FindCycleNumbers() from what the watch knows
+///////////////////////////////////////////////////////////////////////////////
+int N2_WatchCycleNumbers(const tN2watch *W, int RunNo, const char* Subsystem, int *CycNoList[]) {
+	tIntList L={0};
+	tWatchEntry Key={RunNo, -1, -1, -1};
+	for (long long i=WatchFind(W, &Key); i<W->NbEntries and W->Entries[i].RunNo==RunNo; i++)
+		if (0==strcmp(W->Subs.Items[W->Entries[i].Subs], Subsystem) and IntListAdd(&L, W->Entries[i].CycNo)<0) { free(L.Items); return -errno; }
+	return IntListFinish(&L, CycNoList);
+}
 
 ///////////////////////////////////////////////////////////////////////////////
 /// HIFN	Return the min and max run numbers found in the directory
@@ -992,11 +4537,14 @@ void N2_ClearStuff(void) {
 	N2_GetMinMaxRunNumbers(NULL, 0, NULL, NULL, 0);
 	N2_GetMinMaxCycleNumbers(NULL, 0, 0, NULL, NULL, NULL);
 	N2_GetRunNumbersTimeStamps(NULL, 0, NULL, NULL, NULL, NULL, 0);
+	GetCatalog(NULL, 0);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 /// HIFN	Returns the list of runs with their start and end timestamps
-/// HIFN	WARNING: this function is very slow, its output should be cached
+/// HIFN	WARNING: this function is very slow, its output should be cached. 
+/// HIFN	Or at least use N2_OpenHeaderCache() so that the headers are parsed only once
+/// HIFN	See also N2_GetRunNumbersTimeStampsParallel()
 /// HIPAR	OptionalSubsystem / Pass NULL or "" to use the 1st available subsystem
 /// HIPAR	RunNumbers / List of run numbers. You need to free this after use
 /// HIPAR	RunStarts / Timestamp of start of corresponding run. You need to free this after use
@@ -1025,6 +4573,7 @@ int N2_GetRunNumbersTimeStamps(const char* RootDirName, int Direct,
 		
 	for (int iR=0; iR<NR; iR++) {
 		const char *Subs;
+		NS=0;	// Nothing to free at Skip unless the subsystems were listed for this run
 		if (OptionalSubsystem==NULL or *OptionalSubsystem=='\0') {
 			NS=N2_GetSubsystems(RootDirName, Direct, (*RunNumbers)[iR], &Subsystems);
 			if (NS<=0) { (*RunStarts)[iR]=(*RunEnds)[iR]=-9998/*(NS==0?-9998:NS)*/; goto Skip; }
@@ -1066,6 +4615,270 @@ Skip:
 	return NR;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	Runs shared by the threads of N2_GetRunNumbersTimeStampsParallel()
+///////////////////////////////////////////////////////////////////////////////
+typedef struct sRunTsJob {
+	const char *RootDirName, *OptionalSubsystem;
+	int Direct;
+	const tN2tree *Tree;
+	long long *RunStarts, *RunEnds;	// Filled in place, one slot per run
+	int Next;						// Next run to take
+} tRunTsJob;
+
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	Thread function: takes runs until there are none left and reads their 1st and last headers. Arg is a tRunTsJob
+///////////////////////////////////////////////////////////////////////////////
+static void* RunTimeStamps(void* Arg) {
+	tRunTsJob *J=Arg;
+	tN2data N2data={0};
+	for (int i; (i=__sync_fetch_and_add(&J->Next, 1))<J->Tree->NbRuns; ) {
+		const tN2runNode *Run=&J->Tree->Runs[i];
+		const tN2subsNode *S=NULL;
+		if (J->OptionalSubsystem==NULL or *J->OptionalSubsystem=='\0') {
+			if (Run->NbSubs==0) { J->RunStarts[i]=J->RunEnds[i]=-9998; continue; }
+			S=&Run->Subs[0];	// Same as N2_GetRunNumbersTimeStamps(), but always the 1st in alphabetical order
+		} else for (int k=0; k<Run->NbSubs and S==NULL; k++)
+			if (0==strcmp(Run->Subs[k].Name, J->OptionalSubsystem)) S=&Run->Subs[k];
+		if (S==NULL or S->NbCycles==0) { J->RunStarts[i]=J->RunEnds[i]=-9997; continue; }
+		
+		const tN2cycleNode *First=&S->Cycles[0], *Last=&S->Cycles[S->NbCycles-1];	// The run ends with the last part of its last cycle
+		int R=N2_ReadConfig(N2_MakePathName(1, J->RootDirName, J->Direct, Run->RunNo, First->CycNo, First->SizeIdx[0], S->Name, 0), &N2data, 1);
+		J->RunStarts[i]=(R>0 ? N2data.FirstTimeStamp : R==0 ? -9999 : R);
+		N2_ClearConfig(&N2data);
+		R=N2_ReadConfig(N2_MakePathName(1, J->RootDirName, J->Direct, Run->RunNo, Last->CycNo, Last->SizeIdx[Last->NbParts-1], S->Name, 0), &N2data, 1);
+		J->RunEnds[i]  =(R>0 ? N2data.LastTimeStamp  : R==0 ? -9999 : R);
+		N2_ClearConfig(&N2data);
+	}
+	return NULL;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	Same as N2_GetRunNumbersTimeStamps(), but the subsystems and cycles of all the runs come from one
+/// HIFN	N2_WalkStore() instead of a scan per run, and the headers of the runs are read by several threads
+/// HIFN	Each run takes the 1st subsystem in alphabetical order, so the result doesn't depend on the directory order
+/// HIPAR	NbThreads / Number of threads, 0 for the number of cores
+/// HIRET	Possible error code (don't free in that case) or number of runs (size of arrays)
+///////////////////////////////////////////////////////////////////////////////
+int N2_GetRunNumbersTimeStampsParallel(const char* RootDirName, int Direct, 
+									   const char* OptionalSubsystem, 
+									   int *RunNumbers[], 
+									   long long *RunStarts[], long long *RunEnds[], 
+									   const int StartFromRunNo, int NbThreads) {
+	SLOG(SDBG, "Enter");
+	tN2tree Tree;
+	int NR=N2_WalkStore(RootDirName, Direct, &Tree, StartFromRunNo, NbThreads);
+	if (NR<=0) { if (NR==0) N2_FreeTree(&Tree); return NR; }
+	
+	int *List=realloc(*RunNumbers, NR*sizeof(int));
+	if (List) *RunNumbers=List;
+	*RunStarts=calloc(NR, sizeof(long long));
+	*RunEnds  =calloc(NR, sizeof(long long));
+	if (List==NULL or *RunStarts==NULL or *RunEnds==NULL) { 
+		SLOG(SERR, "Out of mem"); 
+		N2_FreeTree(&Tree); 
+		return -(errno=ENOMEM); 
+	}
+	for (int i=0; i<NR; i++) List[i]=Tree.Runs[i].RunNo;
+	
+	tRunTsJob J={ .RootDirName=RootDirName, .OptionalSubsystem=OptionalSubsystem, .Direct=Direct, 
+				  .Tree=&Tree, .RunStarts=*RunStarts, .RunEnds=*RunEnds };
+	if (NbThreads<=0) NbThreads=(int)sysconf(_SC_NPROCESSORS_ONLN);
+	if (NbThreads>NR) NbThreads=NR;
+	if (NbThreads<1) NbThreads=1;
+	pthread_t Threads[NbThreads];
+	int Started=0;
+	for (; Started<NbThreads-1; Started++)
+		if (pthread_create(&Threads[Started], NULL, RunTimeStamps, &J)) break;	// The others do more
+	RunTimeStamps(&J);
+	for (int t=0; t<Started; t++) pthread_join(Threads[t], NULL);
+	SLOG(SNTC, "%d runs with %d threads", NR, Started+1);
+	
+	N2_FreeTree(&Tree);
+	return NR;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Index of the time ranges of all the cycles, to find which ones cover a date.
+// The spans are sorted by start, with the running maximum of their ends, so that a query is 
+// two binary searches: the spans starting after the range are excluded by the 1st, 
+// the ones that all end before by the 2nd. Cycles barely overlap, so there is little left to filter
+///////////////////////////////////////////////////////////////////////////////
+
+struct sN2timeIndex {
+	long long Nb;
+	tN2span *Spans;				// Sorted by FirstTimeStamp
+	long long *MaxEnd;			// [i]: max of Spans[0..i].LastTimeStamp
+	int NbSubs;
+	char **Subs;				// Names pointed to by Spans[].Subsystem
+};
+
+static int CompareSpans(const void *A, const void *B) {
+	const tN2span *a=A, *b=B;
+	if (a->FirstTimeStamp!=b->FirstTimeStamp) return a->FirstTimeStamp<b->FirstTimeStamp ? -1 : 1;
+	if (a->RunNo!=b->RunNo) return a->RunNo<b->RunNo ? -1 : 1;
+	return a->CycNo-b->CycNo;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	Add a span, with its subsystem name shared
+/// HIPAR	Size / Allocated size of Index->Spans, updated
+/// HIRET	-errno or 0
+///////////////////////////////////////////////////////////////////////////////
+static int AddSpan(tN2timeIndex *Index, long long *Size, int RunNo, int CycNo, int SizeIdx, const char* Subsystem, 
+				   long long FirstTimeStamp, long long LastTimeStamp) {
+	int S=0;
+	while (S<Index->NbSubs and strcmp(Index->Subs[S], Subsystem)) S++;
+	if (S==Index->NbSubs) {
+		char **Subs=realloc(Index->Subs, (S+1)*sizeof(char*));
+		if (Subs==NULL) return -(errno=ENOMEM);
+		Index->Subs=Subs;
+		if (NULL==(Index->Subs[S]=strdup(Subsystem))) return -(errno=ENOMEM);
+		Index->NbSubs++;
+	}
+	if (Index->Nb==*Size) {
+		tN2span *Spans=realloc(Index->Spans, (*Size=2*(*Size)+1024)*sizeof(tN2span));
+		if (Spans==NULL) return -(errno=ENOMEM);
+		Index->Spans=Spans;
+	}
+	Index->Spans[Index->Nb++]=(tN2span){ .RunNo=RunNo, .CycNo=CycNo, .SizeIdx=SizeIdx, .Subsystem=Index->Subs[S], 
+									    .FirstTimeStamp=FirstTimeStamp, 
+										.LastTimeStamp=(LastTimeStamp<FirstTimeStamp ? FirstTimeStamp : LastTimeStamp) };
+	return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	Build the index of the time range of every cycle of the store, from the catalog (see N2_UpdateCatalog())
+/// HIFN	or else from the headers (use N2_OpenHeaderCache() to make this faster)
+/// HIPAR	OptionalSubsystem / Only index this subsystem. NULL or "" for all
+/// HIRET	NULL on error, see errno
+///////////////////////////////////////////////////////////////////////////////
+tN2timeIndex* N2_BuildTimeIndex(const char* RootDirName, int Direct, const char* OptionalSubsystem) {
+	SLOG(SDBG, "Enter: %s", RootDirName);
+	int All=(OptionalSubsystem==NULL or *OptionalSubsystem=='\0'), R=0;
+	long long Size=0;
+	tN2timeIndex *Index=calloc(1, sizeof(tN2timeIndex));
+	if (Index==NULL) { errno=ENOMEM; return NULL; }
+	
+	const tCatalog *Cat=GetCatalog(RootDirName, Direct);
+	if (Cat) {
+		for (long long i=0; i<Cat->NbEntries and R>=0; i++) {
+			const tCatEntry *E=&Cat->Entries[i];
+			if (E->Subs<0 or E->NbRow<0 or E->FirstTimeStamp==0 or (!All and strcmp(Cat->Subs[E->Subs], OptionalSubsystem))) continue;
+			R=AddSpan(Index, &Size, E->RunNo, E->CycNo, E->SizeIdx, Cat->Subs[E->Subs], E->FirstTimeStamp, E->LastTimeStamp);
+		}
+	} else {	// Same content as the catalog: every SizeIdx part, without the empty headers
+		tN2tree Tree;
+		tN2data N2data={0};
+		N2data.UseArena=1;	// Reused for every header
+		int NR=N2_WalkStore(RootDirName, Direct, &Tree, 0, 0);	// Frees the tree itself on error
+		if (NR<0) R=NR;
+		for (int iR=0; iR<Tree.NbRuns and R>=0; iR++) {
+			const tN2runNode *Run=&Tree.Runs[iR];
+			for (int iS=0; iS<Run->NbSubs and R>=0; iS++) {
+				const tN2subsNode *S=&Run->Subs[iS];
+				if (!All and strcmp(S->Name, OptionalSubsystem)) continue;
+				for (int iC=0; iC<S->NbCycles and R>=0; iC++) 
+					for (int iP=0; iP<S->Cycles[iC].NbParts and R>=0; iP++) {
+						int CycNo=S->Cycles[iC].CycNo, SizeIdx=S->Cycles[iC].SizeIdx[iP];
+						if (N2_ReadConfig(N2_MakePathName(1, RootDirName, Direct, Run->RunNo, CycNo, SizeIdx, S->Name, 0), &N2data, 1)<0 
+							or N2data.FirstTimeStamp==0) 
+							continue;	// Invalid, ignored like elsewhere
+						R=AddSpan(Index, &Size, Run->RunNo, CycNo, SizeIdx, S->Name, N2data.FirstTimeStamp, N2data.LastTimeStamp);
+					}
+			}
+		}
+		N2_ClearConfig(&N2data);
+		if (NR>=0) N2_FreeTree(&Tree);
+	}
+	
+	if (R>=0 and NULL==(Index->MaxEnd=malloc((Index->Nb+1)*sizeof(long long)))) R=-(errno=ENOMEM);
+	if (R<0) { N2_FreeTimeIndex(Index); errno=-R; return NULL; }
+	qsort(Index->Spans, Index->Nb, sizeof(tN2span), CompareSpans);
+	for (long long i=0; i<Index->Nb; i++) 
+		Index->MaxEnd[i]=(i==0 or Index->Spans[i].LastTimeStamp>Index->MaxEnd[i-1] ? Index->Spans[i].LastTimeStamp : Index->MaxEnd[i-1]);
+	SLOG(SNTC, "%lld cycles indexed", Index->Nb);
+	errno=0;
+	return Index;
+}
+
+void N2_FreeTimeIndex(tN2timeIndex *Index) {
+	if (Index==NULL) return;
+	for (int i=0; i<Index->NbSubs; i++) free(Index->Subs[i]);
+	free(Index->Subs); free(Index->Spans); free(Index->MaxEnd); free(Index);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	Find the cycles whose time range intersects [TimeStampLow, TimeStampHigh], in O(log n)
+/// HIPAR	TimeStampHigh / Same as TimeStampLow to find the cycles covering a single date
+/// HIPAR	Spans / Returned array in chronological order, passed by reference, initially NULL. 
+/// HIPAR	Spans / You should free it, or give it again to the function which will reuse it. Valid as long as the Index
+/// HIRET	Number of spans found, or -errno
+///////////////////////////////////////////////////////////////////////////////
+long long N2_FindInTimeIndex(const tN2timeIndex *Index, long long TimeStampLow, long long TimeStampHigh, tN2span *Spans[]) {
+	long long Lo=0, Hi=Index->Nb;	// First span starting after the range
+	while (Lo<Hi) {
+		long long Mid=Lo+(Hi-Lo)/2;
+		if (Index->Spans[Mid].FirstTimeStamp<=TimeStampHigh) Lo=Mid+1; else Hi=Mid;
+	}
+	long long End=Lo;
+	Lo=0; Hi=End;					// First span that may end in the range
+	while (Lo<Hi) {
+		long long Mid=Lo+(Hi-Lo)/2;
+		if (Index->MaxEnd[Mid]<TimeStampLow) Lo=Mid+1; else Hi=Mid;
+	}
+	tN2span *New=realloc(*Spans, (End-Lo+1)*sizeof(tN2span));
+	if (New==NULL) return -(errno=ENOMEM);
+	*Spans=New;
+	long long Nb=0;
+	for (long long i=Lo; i<End; i++)
+		if (Index->Spans[i].LastTimeStamp>=TimeStampLow) (*Spans)[Nb++]=Index->Spans[i];
+	return Nb;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	Find the runs that have data between two dates, using N2_BuildTimeIndex() on all subsystems
+/// HIPAR	StartTimeStamp, EndTimeStamp / Range of dates, 0 for no limit. Pass the same date twice for a single date
+/// HIPAR	RunNoMin, RunNoMax / First and last runs with data in the range
+/// HIPAR	TimeStampOfStartRun, TimeStampOfEndRun / Optional: start of the 1st run and end of the last one
+/// HIRET	Number of runs in the range or -errno
+///////////////////////////////////////////////////////////////////////////////
+int N2_GetRunNumbersBetweenDates(const char* RootDirName, int Direct, long long StartTimeStamp, 
+								 long long EndTimeStamp, int *RunNoMin, int *RunNoMax,
+								 long long *TimeStampOfStartRun, long long *TimeStampOfEndRun) {
+	SLOG(SDBG, "Enter");
+	tN2timeIndex *Index=N2_BuildTimeIndex(RootDirName, Direct, NULL);
+	if (Index==NULL) return -errno;
+	tN2span *Spans=NULL;
+	long long Nb=N2_FindInTimeIndex(Index, StartTimeStamp, EndTimeStamp ? EndTimeStamp : LLONG_MAX, &Spans);
+	int R=0;
+	*RunNoMin=*RunNoMax=0;
+	if (TimeStampOfStartRun) *TimeStampOfStartRun=0;
+	if (TimeStampOfEndRun  ) *TimeStampOfEndRun  =0;
+	int *Runs=(Nb<0 ? NULL : malloc((Nb+1)*sizeof(int)));
+	if (Nb<0) R=(int)Nb;
+	else if (Runs==NULL) R=-(errno=ENOMEM);
+	else if (Nb>0) {	// Count the runs
+		for (long long i=0; i<Nb; i++) Runs[i]=Spans[i].RunNo;
+		qsort(Runs, Nb, sizeof(int), CompareInt);
+		for (long long i=0; i<Nb; i++) R+=(i==0 or Runs[i]!=Runs[i-1]);
+		*RunNoMin=Runs[0]; *RunNoMax=Runs[Nb-1];
+		
+		// Limits of those two runs from all their cycles, not only the ones in the range
+		for (long long i=0; i<Index->Nb; i++) {
+			const tN2span *S=&Index->Spans[i];
+			if (TimeStampOfStartRun and S->RunNo==*RunNoMin and (*TimeStampOfStartRun==0 or S->FirstTimeStamp<*TimeStampOfStartRun)) 
+				*TimeStampOfStartRun=S->FirstTimeStamp;
+			if (TimeStampOfEndRun   and S->RunNo==*RunNoMax and S->LastTimeStamp>*TimeStampOfEndRun) 
+				*TimeStampOfEndRun=S->LastTimeStamp;
+		}
+	}
+	free(Runs);
+	free(Spans);
+	N2_FreeTimeIndex(Index);
+	return R;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 
 
@@ -1087,12 +4900,13 @@ int main(int argc, char *argv[]) {
 	
 	if (argc==2 and 0==strcmp(argv[1]+strlen(argv[1])-3, ".hd")) {
 		N2_ReadFile(argv[1], &N2data);
-		int NbCol, NbRow;
+		int NbCol;
+		long long NbRow;
 		NbCol = N2data.NbCol;
 		NbRow = N2data.NbRow;
-		printf("%s %i %i %i \n",N2data.Name,N2data.CycNo,N2data.NbRow,N2data.NbCol);
+		printf("%s %i %lli %i \n",N2data.Name,N2data.CycNo,N2data.NbRow,N2data.NbCol);
 		int thisCol = 9;
-		for( int row = 0 ; row < NbRow ; ++row ){
+		for( long long row = 0 ; row < NbRow ; ++row ){
 			double val = (double**) N2data.Data[row][9];
 			printf("%f \n",val);
 		}
@@ -1,13 +1,16 @@
 #ifndef __N2_READ_DATA_H
 #define __N2_READ_DATA_H
 
-// NOTE: this library is multithreadable thanks to thread specific static variables. No locks are used.
+// NOTE: this library is multithreadable thanks to thread specific static variables. No locks are used, 
+// except around the optional header cache (N2_OpenHeaderCache).
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
 
+struct sN2arena;	// Internal
+
 typedef struct sColumn {
 	char *Name, *Description, *DataType;
 } tColumn;
@@ -26,15 +29,26 @@ typedef struct sN2data {
 
 	tColumn *Columns;	// Contains the column headers. Size NbCol
 	char **Labels;		// Simplified version of Columns. Size NbCol
+	int NbFileCol;		// Number of columns in the data file. Differs from NbCol only after a projection
+	int *FileCol;		// After a projection, [NbCol] index of each kept column in the data file. NULL otherwise
 	
 	long long FirstTimeStamp, LastTimeStamp, LastWrite;	// Not sure what last one is for
 	
 	// Content coming from data file (.EDMdat)
-	int NbRow, 						// Number of rows in TimeStamp[] and Data[][]
+	long long NbRow, 				// Number of rows in TimeStamp[] and Data[][]. 64 bits for files over 2 GiB
 		ReservedSize;				// Number of reserved rows in the array, to optimize realloc
 	/*unsigned*/ long long *TimeStamp;	// [NbRow] in ns -> reduplicated in Data[][0] in s
 	void **Data;					// Array of [NbRow][NbCol], with some columns being uint64 and others being double,
 									// depending on Columns[].DataType. All items 8 bytes anyway
+	
+	// Optional columnar layout (structure of arrays). Set it before reading, it survives N2_ClearConfig()
+	int Columnar;					// 0: rows in Data[NbRow][NbCol] (default). 1: columns in Cols[NbCol][NbRow], Data stays NULL
+	void **Cols;					// Array of [NbCol] contiguous columns of ReservedSize items, cache-line aligned.
+									// Cols[0] is RelTime in s. TimeStamp[] is aligned the same way in this mode
+	int NbThreads;					// Reading option: number of threads to read a single large file (0 or 1: serial). Survives N2_ClearConfig()
+	int UseArena;					// Reading option: allocate the headers, strings and rows from a few big chunks released at once,
+									// and reused by the next N2_ReadConfig(). Don't free() any of those yourself. Survives N2_ClearConfig()
+	struct sN2arena *Arena;			// Internal
 	//unsigned long long *EOL;		// [NbRow]
 	// Other unneeded parameters include githash, compileDate, compileTime, swVersionMajor, swVersionMinor, 
 	//                                   nodeGithash, nodeCompileDate, nodeCompileTime, nodeSwVersionMajor, nodeSwVersionMinor...
@@ -46,6 +60,102 @@ typedef struct sN2data {
 } tN2data;
 
 
+// Read-only zero-copy view of a data file mapped in memory, see N2_MapFile()
+typedef struct sN2view {
+	const long long *Base;			// Start of the mapped .EDMdat, NULL if empty
+	long long Size;					// Mapped size in bytes
+	long long NbRow;				// Number of complete records
+	int NbCol;						// Same as tN2data: the timestamp is counted, the EOL is not
+	int Stride;						// Record width in 8-byte items: NbCol+1
+} tN2view;
+
+// Strided accessors, O(1) for any row. Col 0 is the raw timestamp in ns (not RelTime), Col NbCol is the EOL
+static inline long long          N2_ViewTimeStamp(const tN2view *V, long long Row)          { return V->Base[Row*V->Stride]; }
+static inline long long          N2_ViewInt      (const tN2view *V, long long Row, int Col) { return V->Base[Row*V->Stride+Col]; }
+static inline double             N2_ViewDouble   (const tN2view *V, long long Row, int Col) { return ((const double*)V->Base)[Row*V->Stride+Col]; }
+static inline unsigned long long N2_ViewEOL      (const tN2view *V, long long Row)          { return V->Base[Row*V->Stride+V->NbCol]; }
+// First item of a column, the next ones being every V->Stride items
+static inline const long long*   N2_ViewColumn   (const tN2view *V, int Col)                { return V->Base+Col; }
+
+// To read a data file by chunks, see N2_OpenStream()
+typedef struct sN2stream {
+	tN2data N2data;					// Config, and the current chunk in TimeStamp[] and Cols[][]. Always columnar
+	long long Row;					// Index in the file of the 1st row of the current chunk
+	long long NbRowTotal;			// Number of rows in the file
+	int ChunkRows;					// Max number of rows in a chunk
+	int fd, RecSize;				// Internal
+	long long *Block;				// Internal read buffer
+} tN2stream;
+
+// Data file being written, see N2_OpenFollow()
+typedef struct sN2follow {
+	tN2data N2data;					// Config, and the rows read. Always columnar
+	long long Row;					// Index in the file of the 1st row of N2data
+	long long NbRowTotal;			// Number of rows read from the file so far
+	int fd, RecSize, BlockRows;		// Internal
+	long long *Block;				// Internal read buffer
+} tN2follow;
+
+// One cycle of a run, for N2_OpenPrefetch(). Each of its SizeIdx parts is read as a separate file
+typedef struct sN2fileId {
+	int RunNo, CycNo;
+	const char *Subsystem;
+} tN2fileId;
+
+typedef struct sN2prefetch tN2prefetch;	// Internal, see N2_OpenPrefetch()
+
+// Time range of one cycle file, see N2_FindInTimeIndex()
+typedef struct sN2span {
+	int RunNo, CycNo, SizeIdx;
+	const char *Subsystem;			// Owned by the index
+	long long FirstTimeStamp, LastTimeStamp;
+} tN2span;
+
+typedef struct sN2timeIndex tN2timeIndex;	// Internal, see N2_BuildTimeIndex()
+
+// Change in a watched LiveData directory, see N2_ReadWatch()
+#define N2_WATCH_CREATED  1
+#define N2_WATCH_CLOSED   2			// Closed after writing, or moved in: the file is complete
+#define N2_WATCH_REMOVED  3			// Deleted or moved out
+#define N2_WATCH_OVERFLOW 4			// Events were lost, the directory was scanned again. Nothing else is set
+typedef struct sN2watchEvent {
+	int What;
+	int IsHeader;					// 1 for the .hd file, 0 for the .EDMdat
+	int RunNo, CycNo, SizeIdx, HdrVer;
+	char Subsystem[80];
+} tN2watchEvent;
+
+typedef struct sN2watch tN2watch;	// Internal, see N2_OpenWatch()
+
+// Content of a store, see N2_WalkStore(). Everything is sorted
+typedef struct sN2cycleNode {
+	int CycNo, NbParts;
+	const int *SizeIdx;				// [NbParts]
+} tN2cycleNode;
+
+typedef struct sN2subsNode {
+	const char *Name;
+	int NbCycles;
+	const tN2cycleNode *Cycles;		// [NbCycles]
+} tN2subsNode;
+
+typedef struct sN2runNode {
+	int RunNo, NbSubs;				// NbSubs can be 0 for an empty run directory
+	const tN2subsNode *Subs;		// [NbSubs]
+} tN2runNode;
+
+typedef struct sN2tree {
+	int NbRuns;
+	tN2runNode *Runs;				// [NbRuns]
+	int NbSubsystems;
+	char **Subsystems;				// [NbSubsystems] all the names found
+	void *Internal[3];
+} tN2tree;
+
+// Access a single item whatever the layout, Type being double or long long. Ex: N2_CELL(&N2data, r, 1, double)
+#define N2_CELL(N2data, Row, Col, Type) ((N2data)->Columnar ? ((Type*)(N2data)->Cols[Col])[Row] : ((Type**)(N2data)->Data)[Row][Col])
+
+
 // Those functions don't open any files, they only explore the directories
 extern int  N2_GetRunNumbers  (const char* RootDirName, int Direct, int *RunNoList[], const int PartialRunNo);
 extern int  N2_GetSubsystems  (const char* RootDirName, int Direct, int  RunNo,       char**SubsList[]);
@@ -56,31 +166,119 @@ extern int  N2_GetMinMaxRunNumbers  (const char* RootDirName, int Direct,
 extern int  N2_GetMinMaxCycleNumbers(const char* RootDirName, int Direct, int  RunNo, const char* Subsystem, 
 									 int *CycNoMin, int *CycNoMax);
 extern void N2_ClearStuff(void);
+
+// Same as above, but the lists have exactly the size needed and are sorted. Free them with free() or N2_FreeStrings()
+extern int  N2_FindRunNumbers  (const char* RootDirName, int Direct, int StartFromRunNo, int *RunNoList[]);
+extern int  N2_FindSubsystems  (const char* RootDirName, int Direct, int RunNo, char **SubsList[]);
+extern int  N2_FindCycleNumbers(const char* RootDirName, int Direct, int RunNo, const char* Subsystem, int *CycNoList[]);
+extern void N2_FreeStrings     (int N, char *List[]);
+// Live monitoring of a directory with the Direct=1 layout: events as files arrive, and the same 
+// discovery results kept up to date in memory. A watch must not be used by several threads at once
+extern tN2watch* N2_OpenWatch        (const char* DirName);
+extern int       N2_ReadWatch        (tN2watch *W, tN2watchEvent Events[], int MaxEvents, int TimeoutMs);
+extern int       N2_WatchFd          (const tN2watch *W);
+extern int       N2_WatchRunNumbers  (const tN2watch *W, int StartFromRunNo, int *RunNoList[]);
+extern int       N2_WatchSubsystems  (const tN2watch *W, int RunNo, char **SubsList[]);
+extern int       N2_WatchCycleNumbers(const tN2watch *W, int RunNo, const char* Subsystem, int *CycNoList[]);
+extern void      N2_CloseWatch       (tN2watch *W);
+
+// All of the above at once: one walk through the directories, in parallel, gives the whole tree of runs/subsystems/cycles
+extern int  N2_WalkStore(const char* RootDirName, int Direct, tN2tree *Tree, int StartFromRunNo, int NbThreads);
+extern void N2_FreeTree (tN2tree *Tree);
+
+// Catalog file in RootDirName, used by the functions above instead of exploring the directories when it exists.
+// Updating it only scans the runs from the last one already in the catalog. Returns -errno or the number of runs.
+// Runs written after the update are found the same way, by scanning from the last run of the catalog
+extern int  N2_UpdateCatalog(const char* RootDirName, int Direct, int Rebuild);
+extern int  N2_RemoveCatalog(const char* RootDirName);
 	
-//extern int N2_GetRunNumbersBetweenDates(const char* RootDirName, int Direct, long long StartTimeStamp, 
-//										long long EndTimeStamp, int *RunNoMin, int *RunNoMax,
-//										long long *TimeStampOfStartRun, long long *TimeStampOfEndRun);
+extern int N2_GetRunNumbersBetweenDates(const char* RootDirName, int Direct, long long StartTimeStamp, 
+										long long EndTimeStamp, int *RunNoMin, int *RunNoMax,
+										long long *TimeStampOfStartRun, long long *TimeStampOfEndRun);
 int N2_GetRunNumbersTimeStamps(const char* RootDirName, int Direct, 
 							   const char* OptionalSubsystem, 
 							   int *RunNumbers[], 
 							   long long *RunStarts[], long long *RunEnds[],
 							   const int StartFromRunNo);
+// Same, with one walk of the store and the headers read by NbThreads threads (0 for the number of cores)
+extern int N2_GetRunNumbersTimeStampsParallel(const char* RootDirName, int Direct, 
+							   const char* OptionalSubsystem, 
+							   int *RunNumbers[], 
+							   long long *RunStarts[], long long *RunEnds[],
+							   const int StartFromRunNo, int NbThreads);
+// Which cycles cover a date or a time range. Ex: what happened at 14:32:
+// I=N2_BuildTimeIndex(Root, 0, NULL); N=N2_FindInTimeIndex(I, T, T, &Spans); ... free(Spans); N2_FreeTimeIndex(I);
+extern tN2timeIndex* N2_BuildTimeIndex (const char* RootDirName, int Direct, const char* OptionalSubsystem);
+extern long long     N2_FindInTimeIndex(const tN2timeIndex *Index, long long TimeStampLow, long long TimeStampHigh, tN2span *Spans[]);
+extern void          N2_FreeTimeIndex  (tN2timeIndex *Index);
 	
 // Those functions only open the header file
 extern int  N2_ReadConfig(const char* ConfigPathName, tN2data *N2data, int Quick);
+// Persistent cache of parsed headers used by N2_ReadConfig() and all the functions that read headers.
+// A header is parsed again only if its size or mtime changed. Shared by all threads
+extern int  N2_OpenHeaderCache(const char* CachePathName);
+extern int  N2_SaveHeaderCache(void);
+extern void N2_CloseHeaderCache(void);
 extern void N2_ClearConfig(tN2data *N2data);
 extern void N2_CopyConfig(tN2data *N2dest, const tN2data *N2source);
-extern int  N2_AddDataWithFilter(tN2data *N2dest, tN2data *N2source, int* Remaining, 
-						int Decimation, int MaxRows, 
+extern long long N2_AddDataWithFilter(tN2data *N2dest, tN2data *N2source, int* Remaining, 
+						int Decimation, long long MaxRows, 
+						long long TimeStampLow, long long TimeStampHigh);
+// Envelope decimation for plots: per bucket of source rows, the min and max of each column, 
+// optionally with the first and last rows. Decimation is the bucket size, or 0 to fit in MaxRows
+#define N2_ENV_MINMAX 1
+#define N2_ENV_M4     2
+extern long long N2_AddDataEnvelope(tN2data *N2dest, tN2data *N2source, int Mode, 
+						int Decimation, long long MaxRows, 
 						long long TimeStampLow, long long TimeStampHigh);
+// As-of join of several datasets sorted by time into one table, see N2_JoinAsOf() for details
+// Tolerance is the max age in ns of a matched row: 0 for an exact match, -1 for no limit
+#define N2_JOIN_MISSING 0xFFFFFFFFFFFFFFFFULL	// uint64 columns without a match within Tolerance. Doubles get NaN
+extern long long N2_JoinAsOf(tN2data *N2dest, tN2data *Inputs[], int NbInputs, long long Tolerance, int Union);
+// Room for NbRows rows in N2data, before a series of N2_AddDataWithFilter() whose total size is known
+extern int  N2_ReserveRows(tN2data *N2data, long long NbRows);
 
 // Those functions open both header and data files
-extern int  N2_ReadFile(const char* ConfigPathName, tN2data *N2data);
+extern long long N2_ReadFile(const char* ConfigPathName, tN2data *N2data);
+// Same but only reads the columns listed in ColList, like "ADC1,ADC2" or "1,2,7". The timestamp is always column 0
+extern long long N2_ReadFileCols(const char* ConfigPathName, tN2data *N2data, const char* ColList);
+// Same, but only reads the rows with TimeStampLow<=TimeStamp<=TimeStampHigh (absolute ns, 0 for no limit). ColList can be NULL
+extern long long N2_ReadFileWindow(const char* ConfigPathName, tN2data *N2data, const char* ColList, 
+								   long long TimeStampLow, long long TimeStampHigh);
+// Same, with the window in seconds from the start of the cycle (StopSec<0 for no limit)
+extern long long N2_ReadFileRelWindow(const char* ConfigPathName, tN2data *N2data, const char* ColList, 
+									  double StartSec, double StopSec);
+// Read a data file by chunks, reusing the same buffers. Ex:
+// for (N2_OpenStream(Path, &S, NULL, 0); N2_NextChunk(&S)>0; ) use S.N2data; N2_CloseStream(&S);
+extern long long N2_OpenStream(const char* ConfigPathName, tN2stream *Stream, const char* ColList, int ChunkRows);
+extern int       N2_NextChunk(tN2stream *Stream);
+extern void      N2_CloseStream(tN2stream *Stream);
+// Follow a data file as it grows, each poll reads only the new whole records. Ex:
+// N2_OpenFollow(Path, &F, NULL); while (live) { if (N2_PollFollow(&F, 1)>0) plot F.N2data; sleep; } N2_FlushFollow(&F, 1); N2_CloseFollow(&F);
+extern int       N2_OpenFollow (const char* ConfigPathName, tN2follow *Follow, const char* ColList);
+extern long long N2_PollFollow (tN2follow *Follow, int KeepOld);
+extern long long N2_FlushFollow(tN2follow *Follow, int KeepOld);
+extern void      N2_CloseFollow(tN2follow *Follow);
+// Read the header, but map the data file instead of reading it. Unmap it before N2_ClearConfig()
+extern long long N2_MapFile(const char* ConfigPathName, tN2data *N2data, tN2view *View);
+extern void      N2_UnmapFile(tN2view *View);
 // If Direct=0, the RootDirName is partly based on RunNo...
-extern int  N2_ReadData(const char* RootDirName, int Direct, 
+extern long long N2_ReadData(const char* RootDirName, int Direct, 
 						int RunNo, int CycNo, int SizeIdx, const char* Subsystem, int HdrVer, 
 						tN2data *N2data, long long AltFirstTimeStamp);
+// All the cycles of a run for one subsystem (with all their SizeIdx parts), read in parallel into one tN2data, with continuous relative time
+extern long long N2_ReadRun(const char* RootDirName, int Direct, int RunNo, const char* Subsystem, 
+						tN2data *N2data, const char* ColList);
 
+// Read the next files in the background while the current one is processed. Ex:
+// P=N2_OpenPrefetch(Root, 0, Files, N, 4, 2, NULL); while ((D=N2_NextPrefetched(P, &R))) use D; N2_ClosePrefetch(P);
+extern tN2prefetch* N2_OpenPrefetch(const char* RootDirName, int Direct, const tN2fileId Files[], int NbFiles, 
+						int Depth, int NbIOThreads, const tN2data *Options);
+extern tN2data*     N2_NextPrefetched(tN2prefetch *Prefetch, long long *R);
+extern void         N2_ClosePrefetch(tN2prefetch *Prefetch);
+// Read many small files (header and data) at once, with io_uring if available, or else a pool of threads.
+// N2data and Results are arrays of NbFiles. Returns the number of files read without error
+extern int N2_ReadBatch(const char* ConfigPathNames[], int NbFiles, tN2data N2data[], long long Results[]);
 
 // Conversions
 extern const char*N2_NanoToDateStr(long long TimeStamp, const char* TimeFrmt);
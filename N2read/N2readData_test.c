@@ -0,0 +1,874 @@
+///////////////////////////////////////////////////////////////////////////////
+// Self-contained checks of N2readData, run by ctest.
+// Synthetic .hd/.EDMdat files are written in a temporary directory.
+// The library source is included so that the static functions can be reached
+///////////////////////////////////////////////////////////////////////////////
+
+#include "N2readData.c"
+
+#define EOLV 0xDEADBEEFCAFEULL
+#define FIRST 1700000000000000000LL
+
+static int NbFail=0;
+#define CHECK(Cond) do { if (!(Cond)) { fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #Cond); NbFail++; } } while (0)
+
+static char Root[64];	// Temporary directory of all the tests
+
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	Make an empty directory in Root for one test
+///////////////////////////////////////////////////////////////////////////////
+static char* NewDir(char Dir[PATH_MAX], const char* Name) {
+	snprintf(Dir, PATH_MAX, "%s/%s", Root, Name);
+	if (mkdir(Dir, 0755)<0) { perror(Dir); exit(1); }
+	return Dir;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	Write a header in the usual format, with optional extra text at the end
+/// HIPAR	Dir / Root of the store, with the run directories made if Direct=0
+///////////////////////////////////////////////////////////////////////////////
+static const char* WriteHeader(const char* Dir, int Direct, int Run, int Cyc, int SizeIdx, const char* Subs, 
+							   int NbCol, long long First, long long Last, const char* Extra) {
+	static char Path[PATH_MAX];
+	if (!Direct) {
+		sprintf(Path, "%s/%03d", Dir, Run/1000); mkdir(Path, 0755);
+		sprintf(Path, "%s/%03d/%03d", Dir, Run/1000, Run%1000); mkdir(Path, 0755);
+	}
+	strcpy(Path, N2_MakePathName(1, Dir, Direct, Run, Cyc, SizeIdx, Subs, 0));
+	FILE *F=fopen(Path, "w");
+	if (F==NULL) { perror(Path); exit(1); }
+	fprintf(F, "# Written by N2readData_test\nname = \"%s\";\nrunNo = %d;\ncycNo = %d;\nEOLidentifier = \"0x%llX\";\n"
+			   "firstTimeStamp = %lldL;\nlastTimeStamp = %lldL;\n/* Columns */\ncolumns = {\n",
+			Subs, Run, Cyc, EOLV, First, Last);
+	for (int i=0; i<NbCol; i++)
+		fprintf(F, "  column_%03d = {\n    columnName = \"%s%d\";\n    columnDescription = \"desc %d\";\n    columnDataType = \"%s\";\n  };\n",
+				i, i ? "ADC" : "timeStamp", i, i, i%2 ? "double" : "uint64");
+	fprintf(F, "};\n%s", Extra ? Extra : "");
+	fclose(F);
+	return Path;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	Append rows to a data file. Row r has TimeStamp[r], and r*100+c in column c (double for odd columns)
+/// HIPAR	BadEvery / Put a wrong EOL marker every that many rows, 0 for none
+/// HIPAR	Partial / Number of bytes of an incomplete record written at the end
+///////////////////////////////////////////////////////////////////////////////
+static void AppendData(const char* Path, int NbCol, const long long *TimeStamp, long long Row0, long long Row1, int BadEvery, int Partial) {
+	FILE *F=fopen(Path, "ab");
+	if (F==NULL) { perror(Path); exit(1); }
+	for (long long r=Row0; r<Row1; r++) {
+		fwrite(&TimeStamp[r], 8, 1, F);
+		for (int c=1; c<NbCol; c++)
+			if (c%2) { double D=r*100+c; fwrite(&D, 8, 1, F); }
+			else { long long L=r*100+c; fwrite(&L, 8, 1, F); }
+		unsigned long long E=(BadEvery and r%BadEvery==0) ? 1 : EOLV;
+		fwrite(&E, 8, 1, F);
+	}
+	if (Partial) fwrite(&TimeStamp[Row1], Partial<8 ? Partial : 8, 1, F);
+	fclose(F);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	Write a header and its data file with the rows Row0 to Row1-1
+/// HIRET	Path of the header
+///////////////////////////////////////////////////////////////////////////////
+static const char* WritePart(const char* Dir, int Direct, int Run, int Cyc, int SizeIdx, const char* Subs, 
+							 int NbCol, const long long *TimeStamp, long long Row0, long long Row1) {
+	const char* Hd=WriteHeader(Dir, Direct, Run, Cyc, SizeIdx, Subs, NbCol, TimeStamp[Row0], TimeStamp[Row1-1], NULL);
+	AppendData(ConfigToDataName(Hd), NbCol, TimeStamp, Row0, Row1, 0, 0);
+	return Hd;
+}
+
+static long long* Regular(long long NbRow, long long First) {	// Timestamps every µs
+	long long *T=malloc((NbRow+1)*sizeof(long long));
+	for (long long r=0; r<=NbRow; r++) T[r]=First+r*1000;
+	return T;
+}
+
+static int CheckRows(const tN2data *N2data, const long long *TimeStamp, long long Row0, long long NbRow) {
+	if (N2data->NbRow!=NbRow) return 0;
+	for (long long i=0; i<NbRow; i++) {
+		long long r=Row0+i;
+		if (N2data->TimeStamp[i]!=TimeStamp[r]) return 0;
+		for (int c=1; c<N2data->NbCol; c++)
+			if (c%2 ? N2_CELL(N2data, i, c, double)!=r*100+c : N2_CELL(N2data, i, c, long long)!=r*100+c) return 0;
+	}
+	return 1;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	The kernel picked for this CPU decodes blocks like the scalar one,
+/// HIFN	and ReadData() returns every row whatever the layout
+///////////////////////////////////////////////////////////////////////////////
+static void TestDecode(void) {
+	tBlockKernel Kernel=GetBlockKernel();
+	srand(1);
+	for (int It=0; It<200; It++) {
+		int W=2+rand()%12, NbRec=rand()%200, EolCol=W-1;
+		long long *Block=malloc(sizeof(long long)*(NbRec*W+1));
+		long long Ref=rand()%2 ? 0 : FIRST;
+		for (int i=0; i<NbRec*W; i++) Block[i]=((long long)rand()<<32)^rand();
+		for (int r=0; r<NbRec; r++) {
+			Block[r*W]=Ref+(long long)rand()*1000;
+			Block[r*W+EolCol]=rand()%7 ? (long long)EOLV : (long long)(EOLV^(1ULL<<(rand()%64)));
+		}
+		long long T[2][256]; double Rel[2][256]; int Bad[2][10];
+		int NbBad0=BlockKernelScalar(Block, NbRec, W, EolCol, EOLV, T[0], Rel[0], Ref, Bad[0], 10);
+		int NbBad1=Kernel           (Block, NbRec, W, EolCol, EOLV, T[1], Rel[1], Ref, Bad[1], 10);
+		CHECK(NbBad0==NbBad1);
+		CHECK(0==memcmp(T[0], T[1], NbRec*sizeof(long long)));
+		CHECK(0==memcmp(Rel[0], Rel[1], NbRec*sizeof(double)));
+		CHECK(0==memcmp(Bad[0], Bad[1], (NbBad0<10 ? NbBad0 : 10)*sizeof(int)));
+		free(Block);
+	}
+
+	const long long NbRow=100000;
+	long long *T=Regular(NbRow, FIRST);
+	const char* Hd=WriteHeader(Root, 1, 1, 1, 0, "hgm", 8, T[0], T[NbRow-1], NULL);
+	AppendData(ConfigToDataName(Hd), 8, T, 0, NbRow, 30000, 3);	// Some bad EOL markers, and an incomplete last record
+	for (int Columnar=0; Columnar<2; Columnar++) {
+		tN2data N2data={0};
+		N2data.Columnar=Columnar;
+		int Level=SimpleLog_FilterLevel(0);	// The wrong EOL markers are expected
+		CHECK(N2_ReadFile(Hd, &N2data)==NbRow);
+		SimpleLog_FilterLevel(Level);
+		CHECK(CheckRows(&N2data, T, 0, NbRow));
+		CHECK(N2_CELL(&N2data, NbRow-1, 0, double)==NANO_TO_SEC(T[NbRow-1]-T[0]));
+		N2_ClearConfig(&N2data);
+	}
+	free(T);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	N2_MapFile() gives the same rows as N2_ReadFile(), without the incomplete last record
+///////////////////////////////////////////////////////////////////////////////
+static void TestMap(void) {
+	char Dir[PATH_MAX];
+	NewDir(Dir, "map");
+	const long long NbRow=1000;
+	long long *T=Regular(NbRow, FIRST);
+	const char* Hd=WriteHeader(Dir, 1, 1, 1, 0, "hgm", 5, T[0], T[NbRow-1], NULL);
+	AppendData(ConfigToDataName(Hd), 5, T, 0, NbRow, 0, 12);
+	tN2data N2data={0};
+	tN2view View;
+	CHECK(N2_MapFile(Hd, &N2data, &View)==NbRow);
+	CHECK(View.NbRow==NbRow and View.NbCol==5 and View.Stride==6 and N2data.NbRow==0);
+	for (long long r=0; r<NbRow; r++) {
+		CHECK(N2_ViewTimeStamp(&View, r)==T[r] and N2_ViewEOL(&View, r)==EOLV);
+		CHECK(N2_ViewDouble(&View, r, 3)==r*100+3 and N2_ViewInt(&View, r, 4)==r*100+4);
+	}
+	CHECK(N2_ViewColumn(&View, 2)[7*View.Stride]==7*100+2);
+	N2_UnmapFile(&View);
+	CHECK(View.Base==NULL);
+	N2_ClearConfig(&N2data);
+	
+	const char* Empty=WriteHeader(Dir, 1, 1, 2, 0, "hgm", 5, T[0], T[0], NULL);
+	AppendData(ConfigToDataName(Empty), 5, T, 0, 0, 0, 0);
+	CHECK(N2_MapFile(Empty, &N2data, &View)==0 and View.Base==NULL);
+	N2_UnmapFile(&View);
+	N2_ClearConfig(&N2data);
+	free(T);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	N2_NextChunk() goes through the whole file by chunks, with or without a projection
+///////////////////////////////////////////////////////////////////////////////
+static void TestStream(void) {
+	char Dir[PATH_MAX];
+	NewDir(Dir, "stream");
+	const long long NbRow=10007;
+	long long *T=Regular(NbRow, FIRST);
+	const char* Hd=WritePart(Dir, 1, 1, 1, 0, "hgm", 6, T, 0, NbRow);
+	tN2stream Stream;
+	CHECK(N2_OpenStream(Hd, &Stream, NULL, 1000)==NbRow);
+	int Nb=0, R;
+	long long Total=0;
+	while ((R=N2_NextChunk(&Stream))>0) {
+		CHECK(Stream.Row==Total and R==(Total+1000<=NbRow ? 1000 : NbRow%1000));
+		CHECK(CheckRows(&Stream.N2data, T, Stream.Row, R));
+		CHECK(N2_CELL(&Stream.N2data, R-1, 0, double)==NANO_TO_SEC(T[Stream.Row+R-1]-T[0]));
+		Total+=R; Nb++;
+	}
+	CHECK(R==0 and Total==NbRow and Nb==11);
+	N2_CloseStream(&Stream);
+	
+	CHECK(N2_OpenStream(Hd, &Stream, "ADC4,1", 4096)==NbRow);
+	CHECK(Stream.N2data.NbCol==3);
+	for (Total=0; (R=N2_NextChunk(&Stream))>0; Total+=R)
+		for (int i=0; i<R; i++)
+			CHECK(N2_CELL(&Stream.N2data, i, 1, long long)==(Total+i)*100+4 and N2_CELL(&Stream.N2data, i, 2, double)==(Total+i)*100+1);
+	CHECK(Total==NbRow);
+	N2_CloseStream(&Stream);
+	
+	CHECK(N2_OpenStream(Hd, &Stream, NULL, 0)==NbRow);	// Default size
+	CHECK(N2_NextChunk(&Stream)==NbRow and N2_NextChunk(&Stream)==0);
+	N2_CloseStream(&Stream);
+	free(T);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	N2_ReadRun() reads every part of every cycle in order, with or without the catalog
+///////////////////////////////////////////////////////////////////////////////
+static void TestReadRun(void) {
+	char Dir[PATH_MAX];
+	NewDir(Dir, "run");
+	const long long NbRow=320;
+	long long *T=Regular(NbRow, FIRST);
+	static const struct { int Cyc, SizeIdx, Row0, Row1; } Parts[]={	// Written out of order
+		{ 3, 2, 290, 320 }, { 1, 0, 0, 100 }, { 2, 0, 150, 220 }, { 1, 1, 100, 150 }, { 3, 0, 220, 260 }, { 3, 1, 260, 290 } };
+	for (int i=0; i<6; i++) WritePart(Dir, 0, 7, Parts[i].Cyc, Parts[i].SizeIdx, "hgm", 5, T, Parts[i].Row0, Parts[i].Row1);
+	WritePart(Dir, 0, 7, 1, 0, "oth", 3, T, 0, 10);	// Other subsystem
+	WritePart(Dir, 0, 7, 4, 0, "hgm", 3, T, 0, 10);		// Other number of columns: skipped
+	for (int Pass=0; Pass<3; Pass++) {
+		if (Pass==2) CHECK(N2_UpdateCatalog(Dir, 0, 1)==1);
+		tN2data N2data={0};
+		N2data.Columnar=(Pass==1);
+		int Level=SimpleLog_FilterLevel(0);	// The skipped part is expected
+		CHECK(N2_ReadRun(Dir, 0, 7, "hgm", &N2data, NULL)==NbRow);
+		SimpleLog_FilterLevel(Level);
+		CHECK(CheckRows(&N2data, T, 0, NbRow));
+		CHECK(N2_CELL(&N2data, NbRow-1, 0, double)==NANO_TO_SEC(T[NbRow-1]-T[0]));
+		N2_ClearConfig(&N2data);
+	}
+	tN2data N2data={0};
+	int Level=SimpleLog_FilterLevel(0);
+	CHECK(N2_ReadRun(Dir, 0, 7, "hgm", &N2data, "ADC2")==NbRow);
+	SimpleLog_FilterLevel(Level);
+	CHECK(N2data.NbCol==2 and N2_CELL(&N2data, 123, 1, long long)==123*100+2);
+	N2_ClearConfig(&N2data);
+	N2_RemoveCatalog(Dir);
+	free(T);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	Check a list of run or cycle numbers, ended by -1
+///////////////////////////////////////////////////////////////////////////////
+static int SameList(int Nb, const int *List, const int *Expected) {
+	for (int i=0; i<Nb; i++) if (List[i]!=Expected[i]) return 0;
+	return Expected[Nb]==-1;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	The runs written after N2_UpdateCatalog() are found anyway, then added by the next incremental update
+///////////////////////////////////////////////////////////////////////////////
+static void TestCatalog(void) {
+	char Dir[2][PATH_MAX];
+	NewDir(Dir[0], "catalog");
+	NewDir(Dir[1], "catalog_direct");
+	long long *T=Regular(10, FIRST);
+	for (int Direct=0; Direct<2; Direct++) {
+		const char* D=Dir[Direct];
+		int *List=NULL;
+		WritePart(D, Direct, 5, 1, 0, "hgm", 3, T, 0, 10);
+		WritePart(D, Direct, 6, 1, 0, "hgm", 3, T, 0, 10);
+		CHECK(N2_UpdateCatalog(D, Direct, 0)==2);
+		usleep(20000);	// The file times have the granularity of the kernel tick
+		
+		WritePart(D, Direct, 6, 2, 0, "hgm", 3, T, 0, 10);	// The last run grows
+		WritePart(D, Direct, 7, 1, 0, "tpc", 3, T, 0, 10);
+		WritePart(D, Direct, 1007, 1, 0, "hgm", 3, T, 0, 10);	// In a new thousands directory
+		for (int Pass=0; Pass<3; Pass++) {
+			if (Pass==1) CHECK(N2_UpdateCatalog(D, Direct, 0)==4);
+			if (Pass==2) CHECK(N2_UpdateCatalog(D, Direct, 0)==4);	// Nothing new
+			int Nb=N2_GetRunNumbers(D, Direct, &List, 0);
+			CHECK(SameList(Nb, List, (int[]){ 5, 6, 7, 1007, -1 }));
+			Nb=N2_GetRunNumbers(D, Direct, &List, 7);
+			CHECK(SameList(Nb, List, (int[]){ 7, 1007, -1 }));
+			Nb=N2_GetCycleNumbers(D, Direct, 6, "hgm", &List);
+			CHECK(SameList(Nb, List, (int[]){ 1, 2, -1 }));
+			char **Subs=NULL;
+			Nb=N2_GetSubsystems(D, Direct, 7, &Subs);
+			CHECK(Nb==1 and 0==strcmp(Subs[0], "tpc"));
+			for (int i=0; i<Nb; i++) free(Subs[i]);
+			free(Subs);
+		}
+		char Path[PATH_MAX+16];
+		snprintf(Path, sizeof(Path), "%s/" CATALOG_NAME, D);
+		tCatalog *Cat=LoadCatalog(Path);
+		CHECK(Cat!=NULL and Cat->NbEntries==5 and Cat->NbSubs==2);
+		FreeCatalog(Cat);
+		N2_RemoveCatalog(D);
+		free(List);
+	}
+	free(T);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	N2_WalkStore() arranges the headers as a tree, and skips the entries that are not readable directories
+///////////////////////////////////////////////////////////////////////////////
+static void TestWalk(void) {
+	char Dir[PATH_MAX], Path[PATH_MAX+16];
+	NewDir(Dir, "walk");
+	long long *T=Regular(10, FIRST);
+	WritePart(Dir, 0, 1, 1, 0, "hgm", 3, T, 0, 10);
+	WritePart(Dir, 0, 1, 1, 1, "hgm", 3, T, 0, 10);
+	WritePart(Dir, 0, 1, 2, 0, "hgm", 3, T, 0, 10);
+	WritePart(Dir, 0, 1, 1, 0, "abc", 3, T, 0, 10);
+	WritePart(Dir, 0, 2003, 4, 0, "hgm", 3, T, 0, 10);
+	snprintf(Path, sizeof(Path), "%s/000/002", Dir); mkdir(Path, 0755);		// Empty run
+	snprintf(Path, sizeof(Path), "%s/000/004", Dir); fclose(fopen(Path, "w"));	// Stray files
+	snprintf(Path, sizeof(Path), "%s/001", Dir);     fclose(fopen(Path, "w"));
+	snprintf(Path, sizeof(Path), "%s/000/005", Dir); CHECK(0==symlink("nowhere", Path));	// Cannot be opened, even by root
+	for (int NbThreads=1; NbThreads<=3; NbThreads+=2) {
+		tN2tree Tree;
+		int Level=SimpleLog_FilterLevel(0);	// The skipped entries are expected
+		CHECK(N2_WalkStore(Dir, 0, &Tree, 0, NbThreads)==3);
+		SimpleLog_FilterLevel(Level);
+		CHECK(Tree.NbRuns==3 and Tree.NbSubsystems==2);
+		if (Tree.NbRuns!=3) { N2_FreeTree(&Tree); continue; }
+		const tN2runNode *R=Tree.Runs;
+		CHECK(R[0].RunNo==1 and R[0].NbSubs==2 and R[1].RunNo==2 and R[1].NbSubs==0 and R[2].RunNo==2003 and R[2].NbSubs==1);
+		CHECK(0==strcmp(R[0].Subs[0].Name, "abc") and R[0].Subs[0].NbCycles==1 and 0==strcmp(R[0].Subs[1].Name, "hgm"));
+		const tN2subsNode *S=&R[0].Subs[1];
+		CHECK(S->NbCycles==2 and S->Cycles[0].CycNo==1 and S->Cycles[0].NbParts==2 and S->Cycles[0].SizeIdx[1]==1);
+		CHECK(S->Cycles[1].CycNo==2 and S->Cycles[1].NbParts==1);
+		CHECK(R[2].Subs[0].Cycles[0].CycNo==4);
+		N2_FreeTree(&Tree);
+	}
+	tN2tree Tree;
+	CHECK(N2_WalkStore(Dir, 0, &Tree, 2000, 0)==1 and Tree.Runs[0].RunNo==2003);
+	N2_FreeTree(&Tree);
+	int Level=SimpleLog_FilterLevel(0);
+	snprintf(Path, sizeof(Path), "%s/nowhere", Dir);
+	CHECK(N2_WalkStore(Path, 1, &Tree, 0, 0)==-ENOENT and N2_WalkStore(Path, 0, &Tree, 0, 0)==-ENOENT);
+	SimpleLog_FilterLevel(Level);
+	free(T);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	N2_Find*() give sorted lists without duplicates, with or without the catalog
+///////////////////////////////////////////////////////////////////////////////
+static void TestFind(void) {
+	char Dir[2][PATH_MAX];
+	NewDir(Dir[0], "find");
+	NewDir(Dir[1], "find_direct");
+	long long *T=Regular(10, FIRST);
+	for (int Direct=0; Direct<2; Direct++) {
+		const char* D=Dir[Direct];
+		WritePart(D, Direct, 1012, 3, 0, "tpc", 3, T, 0, 10);	// Out of order
+		WritePart(D, Direct, 12, 7, 1, "tpc", 3, T, 0, 10);
+		WritePart(D, Direct, 12, 7, 0, "tpc", 3, T, 0, 10);
+		WritePart(D, Direct, 12, 2, 0, "tpc", 3, T, 0, 10);
+		WritePart(D, Direct, 12, 2, 0, "abc", 3, T, 0, 10);
+		WritePart(D, Direct, 3, 1, 0, "hgm", 3, T, 0, 10);
+		for (int WithCatalog=0; WithCatalog<2; WithCatalog++) {
+			if (WithCatalog) CHECK(N2_UpdateCatalog(D, Direct, 0)==3);
+			int *List=NULL;
+			int Nb=N2_FindRunNumbers(D, Direct, 0, &List);
+			CHECK(SameList(Nb, List, (int[]){ 3, 12, 1012, -1 }));
+			free(List);
+			Nb=N2_FindRunNumbers(D, Direct, 12, &List);
+			CHECK(SameList(Nb, List, (int[]){ 12, 1012, -1 }));
+			free(List);
+			Nb=N2_FindCycleNumbers(D, Direct, 12, "tpc", &List);
+			CHECK(SameList(Nb, List, (int[]){ 2, 7, -1 }));
+			free(List);
+			Nb=N2_FindCycleNumbers(D, Direct, 12, "xyz", &List);
+			CHECK(Nb==0);
+			free(List);
+			char **Subs=NULL;
+			Nb=N2_FindSubsystems(D, Direct, 12, &Subs);
+			CHECK(Nb==2 and 0==strcmp(Subs[0], "abc") and 0==strcmp(Subs[1], "tpc"));
+			N2_FreeStrings(Nb, Subs);
+		}
+		N2_RemoveCatalog(D);
+	}
+	free(T);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	N2_ReadWatch() reports the files written, moved in and removed, and the N2_Watch* queries follow
+///////////////////////////////////////////////////////////////////////////////
+static void TestWatch(void) {
+	char Dir[PATH_MAX], Tmp[PATH_MAX], Path[PATH_MAX+16];
+	NewDir(Dir, "watch");
+	NewDir(Tmp, "watch_tmp");
+	long long *T=Regular(10, FIRST);
+	WritePart(Dir, 1, 4, 1, 0, "hgm", 3, T, 0, 10);
+	tN2watch *W=N2_OpenWatch(Dir);
+	CHECK(W!=NULL);
+	if (W==NULL) { free(T); return; }
+	tN2watchEvent Ev[8];
+	CHECK(N2_ReadWatch(W, Ev, 8, 0)==0);
+	
+	WritePart(Dir, 1, 5, 2, 0, "tpc", 3, T, 0, 10);
+	snprintf(Path, sizeof(Path), "%s/notes.txt", Dir); fclose(fopen(Path, "w"));	// Ignored
+	int Nb=0;
+	for (int R; Nb<4 and (R=N2_ReadWatch(W, &Ev[Nb], 1, 1000))>0; Nb+=R);	// One at a time, the others are kept
+	static const int What[]={ N2_WATCH_CREATED, N2_WATCH_CLOSED, N2_WATCH_CREATED, N2_WATCH_CLOSED };
+	CHECK(Nb==4);
+	for (int i=0; i<Nb; i++)
+		CHECK(Ev[i].What==What[i] and Ev[i].IsHeader==(i<2) and Ev[i].RunNo==5 and Ev[i].CycNo==2 and 0==strcmp(Ev[i].Subsystem, "tpc"));
+	int *List=NULL;
+	Nb=N2_WatchRunNumbers(W, 0, &List);
+	CHECK(SameList(Nb, List, (int[]){ 4, 5, -1 }));
+	free(List);
+	Nb=N2_WatchCycleNumbers(W, 5, "tpc", &List);
+	CHECK(SameList(Nb, List, (int[]){ 2, -1 }));
+	free(List);
+	char **Subs=NULL;
+	Nb=N2_WatchSubsystems(W, 5, &Subs);
+	CHECK(Nb==1 and 0==strcmp(Subs[0], "tpc"));
+	N2_FreeStrings(Nb, Subs);
+	
+	const char* Hd=WriteHeader(Tmp, 1, 6, 1, 0, "hgm", 3, T[0], T[9], NULL);	// Moved in: complete at once
+	CHECK(0==rename(Hd, N2_MakePathName(1, Dir, 1, 6, 1, 0, "hgm", 0)));
+	CHECK(0==unlink(N2_MakePathName(1, Dir, 1, 4, 1, 0, "hgm", 0)));
+	CHECK(N2_ReadWatch(W, Ev, 8, 1000)==2);
+	CHECK(Ev[0].What==N2_WATCH_CLOSED and Ev[0].IsHeader and Ev[0].RunNo==6);
+	CHECK(Ev[1].What==N2_WATCH_REMOVED and Ev[1].IsHeader and Ev[1].RunNo==4);
+	Nb=N2_WatchRunNumbers(W, 0, &List);
+	CHECK(SameList(Nb, List, (int[]){ 5, 6, -1 }));
+	free(List);
+	CHECK(N2_ReadWatch(W, Ev, 8, 20)==0);
+	N2_CloseWatch(W);
+	
+	int Level=SimpleLog_FilterLevel(0);
+	CHECK(N2_OpenWatch(Path)==NULL and errno==ENOTDIR);
+	SimpleLog_FilterLevel(Level);
+	free(T);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	N2_GetRunNumbersTimeStampsParallel() gives the same run ranges as N2_GetRunNumbersBetweenDates(),
+/// HIFN	with a last cycle in several parts
+///////////////////////////////////////////////////////////////////////////////
+static void TestRunTimeStamps(void) {
+	char Dir[PATH_MAX];
+	NewDir(Dir, "runts");
+	long long *T=Regular(400, FIRST);
+	WritePart(Dir, 0, 30, 1, 0, "hgm", 3, T, 0, 100);
+	WritePart(Dir, 0, 30, 2, 0, "hgm", 3, T, 100, 150);
+	WritePart(Dir, 0, 30, 2, 1, "hgm", 3, T, 150, 200);
+	WritePart(Dir, 0, 31, 1, 0, "hgm", 3, T, 300, 400);
+	int *Runs=NULL;
+	long long *Starts=NULL, *Ends=NULL;
+	CHECK(N2_GetRunNumbersTimeStampsParallel(Dir, 0, "hgm", &Runs, &Starts, &Ends, 0, 2)==2);
+	if (Runs and Starts and Ends) {
+		CHECK(Runs[0]==30 and Starts[0]==FIRST and Ends[0]==FIRST+199000);
+		CHECK(Runs[1]==31 and Starts[1]==T[300] and Ends[1]==T[399]);
+	}
+	int R0, Rn;
+	long long Start, End;
+	CHECK(N2_GetRunNumbersBetweenDates(Dir, 0, T[10], T[10], &R0, &Rn, &Start, &End)==1);
+	CHECK(R0==30 and Rn==30 and Start==FIRST and End==FIRST+199000);
+	free(Runs); free(Starts); free(Ends);
+	free(T);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	N2_AddDataWithFilter() between all the layouts, and with a different number of columns
+///////////////////////////////////////////////////////////////////////////////
+static void TestAddData(void) {
+	char Dir[PATH_MAX];
+	NewDir(Dir, "add");
+	const long long NbRow=1000;
+	long long *T=Regular(NbRow, FIRST);
+	const char* Hd=WritePart(Dir, 1, 1, 1, 0, "hgm", 5, T, 0, NbRow);
+	for (int L=0; L<4; L++) {
+		tN2data Source={0}, Dest={0}, Other={0};
+		Source.Columnar=L&1;
+		CHECK(N2_ReadFile(Hd, &Source)==NbRow);
+		N2_CopyConfig(&Dest, &Source);
+		Dest.Columnar=L>>1;
+		int Remaining=0;
+		CHECK(N2_AddDataWithFilter(&Dest, &Source, &Remaining, 3, 0, T[100], T[399])==100);
+		CHECK(Dest.NbRow==100);
+		for (int i=0; i<100; i++) {
+			long long r=102+3*i;
+			CHECK(Dest.TimeStamp[i]==T[r] and N2_CELL(&Dest, i, 3, double)==r*100+3 and N2_CELL(&Dest, i, 4, long long)==r*100+4);
+		}
+		Other.Columnar=L>>1;
+		CHECK(N2_ReadFileCols(Hd, &Other, "ADC2")==NbRow);	// Fewer columns
+		Remaining=0;
+		CHECK(N2_AddDataWithFilter(&Other, &Source, &Remaining, 1, 0, 0, 0)==-EINVAL);
+		CHECK(Other.NbRow==NbRow and Remaining==0);
+		N2_ClearConfig(&Source); N2_ClearConfig(&Dest); N2_ClearConfig(&Other);
+	}
+	free(T);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	N2_NextPrefetched() gives every part of the cycles, in order, and an error for a missing cycle
+///////////////////////////////////////////////////////////////////////////////
+static void TestPrefetch(void) {
+	char Dir[PATH_MAX];
+	NewDir(Dir, "prefetch");
+	long long *T=Regular(300, FIRST);
+	WritePart(Dir, 0, 9, 1, 0, "hgm", 4, T, 0, 100);
+	WritePart(Dir, 0, 9, 1, 1, "hgm", 4, T, 100, 200);
+	WritePart(Dir, 0, 9, 2, 0, "hgm", 4, T, 200, 300);
+	tN2fileId Files[]={ { 9, 1, "hgm" }, { 9, 5, "hgm" }, { 9, 2, "hgm" } };	// Cycle 5 doesn't exist
+	tN2data Options={0};
+	Options.Columnar=1;
+	for (int Depth=1; Depth<=3; Depth++) {
+		int Level=SimpleLog_FilterLevel(0);	// The missing cycle is expected. Not changed while the threads run
+		tN2prefetch *P=N2_OpenPrefetch(Dir, 0, Files, 3, Depth, 2, &Options);
+		CHECK(P!=NULL);
+		if (P==NULL) { SimpleLog_FilterLevel(Level); continue; }
+		static const int Cyc[]={ 1, 1, 5, 2 };
+		long long Row=0, R;
+		int Nb=0;
+		for (tN2data *D; (D=N2_NextPrefetched(P, &R))!=NULL; Nb++) {
+			if (Nb>=4) break;
+			if (Cyc[Nb]==5) { CHECK(R<0); continue; }
+			CHECK(R==100 and D->CycNo==Cyc[Nb] and D->Columnar and CheckRows(D, T, Row, 100));
+			Row+=100;
+		}
+		CHECK(Nb==4 and Row==300);
+		N2_ClosePrefetch(P);
+		SimpleLog_FilterLevel(Level);
+	}
+	tN2fileId Bad[]={ { 9, 1, NULL } };
+	int Level=SimpleLog_FilterLevel(0);
+	errno=0;
+	CHECK(N2_OpenPrefetch(Dir, 0, Bad, 1, 1, 1, NULL)==NULL and errno==EINVAL);
+	SimpleLog_FilterLevel(Level);
+	free(T);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	N2_ReadBatch() (io_uring when available) and the pool of threads give the same as N2_ReadFile(),
+/// HIFN	with more files than N2_BATCH_INFLIGHT and some missing ones
+///////////////////////////////////////////////////////////////////////////////
+static void TestBatch(void) {
+	char Dir[PATH_MAX];
+	NewDir(Dir, "batch");
+	enum { NB=N2_BATCH_INFLIGHT+10 };
+	long long *T=Regular(NB, FIRST);
+	char *Paths[NB];
+	for (int i=0; i<NB; i++) 
+		Paths[i]=strdup(i%9==4 ? N2_MakePathName(1, Dir, 1, 7, i, 0, "hgm", 0)	// Missing
+							   : WritePart(Dir, 1, 7, i, 0, "hgm", 2+i%5, T, 0, i+1));
+	for (int Pool=0; Pool<2; Pool++) {
+		static tN2data N2data[NB];
+		long long Results[NB];
+		memset(N2data, 0, sizeof(N2data));
+		for (int i=0; i<NB; i++) N2data[i].Columnar=i%2;
+		int Level=SimpleLog_FilterLevel(0);	// The missing files are expected
+		int Nb=NB-(NB+4)/9;
+		if (Pool) ReadBatchPool((const char**)Paths, NB, N2data, Results);
+		else CHECK(N2_ReadBatch((const char**)Paths, NB, N2data, Results)==Nb);
+		SimpleLog_FilterLevel(Level);
+		for (int i=0; i<NB; i++) {
+			if (i%9==4) { CHECK(Results[i]==-ENOENT); continue; }
+			CHECK(Results[i]==i+1 and N2data[i].CycNo==i and N2data[i].NbCol==2+i%5 and N2data[i].Columnar==i%2);
+			CHECK(CheckRows(&N2data[i], T, 0, i+1));
+			N2_ClearConfig(&N2data[i]);
+		}
+	}
+	for (int i=0; i<NB; i++) free(Paths[i]);
+	free(T);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	Replace the subsystem name inside a header, keeping its size and mtime
+///////////////////////////////////////////////////////////////////////////////
+static void RenameInPlace(const char* Hd, const char* From, const char* To) {
+	struct stat St;
+	char Text[4096];
+	FILE *F=fopen(Hd, "r+");
+	if (F==NULL or stat(Hd, &St)) { perror(Hd); exit(1); }
+	size_t Len=fread(Text, 1, sizeof(Text)-1, F);
+	Text[Len]='\0';
+	char *P=strstr(Text, From);
+	if (P) memcpy(P, To, strlen(To));
+	rewind(F); fwrite(Text, 1, Len, F); fclose(F);
+	struct timespec Times[2]={ St.st_atim, St.st_mtim };
+	utimensat(AT_FDCWD, Hd, Times, 0);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	Headers come from N2_OpenHeaderCache() while unchanged, are parsed again otherwise,
+/// HIFN	and a truncated or foreign cache file is rebuilt
+///////////////////////////////////////////////////////////////////////////////
+static void TestHeaderCache(void) {
+	char Dir[PATH_MAX], Cache[PATH_MAX], Hd[2][PATH_MAX];
+	NewDir(Dir, "hdcache");
+	snprintf(Cache, sizeof(Cache), "%s/hdcache.bin", Root);
+	long long *T=Regular(10, FIRST);
+	for (int i=0; i<2; i++) strcpy(Hd[i], WritePart(Dir, 1, 3, i, 0, "hgm", 3+i, T, 0, 10));
+	tN2data N2data={0};
+
+	CHECK(N2_OpenHeaderCache(Cache)==0);	// Created
+	for (int i=0; i<2; i++) 
+		CHECK(N2_ReadConfig(Hd[i], &N2data, 0)>=0 and N2data.NbCol==3+i and N2data.CycNo==i and N2data.FirstTimeStamp==T[0]);
+	CHECK(N2_SaveHeaderCache()==2);
+	N2_CloseHeaderCache();
+	
+	RenameInPlace(Hd[0], "\"hgm\"", "\"xyz\"");	// Unnoticed by the cache
+	CHECK(N2_OpenHeaderCache(Cache)==2);
+	CHECK(N2_ReadConfig(Hd[0], &N2data, 0)>=0 and 0==strcmp(N2data.Name, "hgm") and N2data.NbCol==3);
+	CHECK(0==strcmp(N2data.Columns[2].Name, "ADC2") and 0==strcmp(N2data.Columns[2].DataType, "uint64"));
+	struct timespec Times[2]={ { 0, UTIME_OMIT }, { 1000000000, 0 } };
+	utimensat(AT_FDCWD, Hd[0], Times, 0);	// Noticed
+	CHECK(N2_ReadConfig(Hd[0], &N2data, 0)>=0 and 0==strcmp(N2data.Name, "xyz"));
+	WritePart(Dir, 1, 3, 1, 0, "hgm", 6, T, 0, 10);	// Other size
+	CHECK(N2_ReadConfig(Hd[1], &N2data, 0)>=0 and N2data.NbCol==6);
+	N2_CloseHeaderCache();
+	
+	struct stat St;
+	CHECK(0==stat(Cache, &St) and 0==truncate(Cache, St.st_size-5));
+	int Level=SimpleLog_FilterLevel(0);	// The truncation is expected
+	CHECK(N2_OpenHeaderCache(Cache)==1);
+	SimpleLog_FilterLevel(Level);
+	for (int i=0; i<2; i++) CHECK(N2_ReadConfig(Hd[i], &N2data, 0)>=0 and N2data.NbCol==(i ? 6 : 3));
+	CHECK(N2_SaveHeaderCache()==2);
+	N2_CloseHeaderCache();
+	
+	FILE *F=fopen(Cache, "w"); fputs("Not a cache", F); fclose(F);
+	Level=SimpleLog_FilterLevel(0);
+	CHECK(N2_OpenHeaderCache(Cache)==0);
+	SimpleLog_FilterLevel(Level);
+	CHECK(N2_ReadConfig(Hd[0], &N2data, 0)>=0 and 0==strcmp(N2data.Name, "xyz"));
+	CHECK(N2_SaveHeaderCache()==1);
+	N2_CloseHeaderCache();
+	N2_ClearConfig(&N2data);
+	free(T);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	Bounds of N2_ReadFileWindow() and N2_ReadFileRelWindow()
+///////////////////////////////////////////////////////////////////////////////
+static void TestWindow(void) {
+	const long long NbRow=10000;
+	long long *T=Regular(NbRow, FIRST);
+	const char* Hd=WriteHeader(Root, 1, 1, 2, 0, "hgm", 4, T[0], T[NbRow-1], NULL);
+	AppendData(ConfigToDataName(Hd), 4, T, 0, NbRow, 0, 0);
+	tN2data N2data={0};
+	CHECK(N2_ReadFileWindow(Hd, &N2data, NULL, T[500]-1, T[700])==201);	// Both ends included
+	CHECK(CheckRows(&N2data, T, 500, 201));
+	N2_ClearConfig(&N2data);
+	CHECK(N2_ReadFileWindow(Hd, &N2data, "2", 0, T[9])==10);
+	CHECK(N2data.NbCol==2 and N2_CELL(&N2data, 9, 1, long long)==9*100+2);
+	N2_ClearConfig(&N2data);
+	CHECK(N2_ReadFileWindow(Hd, &N2data, NULL, T[NbRow-10], 0)==10);
+	N2_ClearConfig(&N2data);
+	CHECK(N2_ReadFileWindow(Hd, &N2data, NULL, 5, 6)==0);		// Before the file
+	N2_ClearConfig(&N2data);
+	CHECK(N2_ReadFileWindow(Hd, &N2data, NULL, T[NbRow-1]+1, 0)==0);	// After
+	N2_ClearConfig(&N2data);
+	CHECK(N2_ReadFileRelWindow(Hd, &N2data, NULL, 500e-6, 700e-6)==201);
+	CHECK(CheckRows(&N2data, T, 500, 201));
+	N2_ClearConfig(&N2data);
+	CHECK(N2_ReadFileRelWindow(Hd, &N2data, NULL, (NbRow-10)*1e-6, -1)==10);
+	N2_ClearConfig(&N2data);
+	free(T);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	N2_FindInTimeIndex() against a brute force search, with and without the catalog
+///////////////////////////////////////////////////////////////////////////////
+#define NB_SPAN 40
+static struct { int RunNo, CycNo, SizeIdx; long long First, Last; } Spans[NB_SPAN];
+
+static void CheckFind(const tN2timeIndex *Index, long long Low, long long High) {
+	tN2span *Found=NULL;
+	long long Nb=N2_FindInTimeIndex(Index, Low, High, &Found), Expected=0;
+	for (int i=0; i<NB_SPAN; i++) Expected+=(Spans[i].First<=High and Spans[i].Last>=Low);
+	CHECK(Nb==Expected);
+	for (long long i=0; i<Nb; i++) {
+		CHECK(Found[i].FirstTimeStamp<=High and Found[i].LastTimeStamp>=Low);
+		CHECK(i==0 or Found[i].FirstTimeStamp>=Found[i-1].FirstTimeStamp);
+		int Known=0;
+		for (int j=0; j<NB_SPAN; j++)
+			Known|=(Spans[j].RunNo==Found[i].RunNo and Spans[j].CycNo==Found[i].CycNo and Spans[j].SizeIdx==Found[i].SizeIdx and
+					Spans[j].First==Found[i].FirstTimeStamp and Spans[j].Last==Found[i].LastTimeStamp);
+		CHECK(Known);
+	}
+	free(Found);
+}
+
+static void TestTimeIndex(void) {
+	long long First=FIRST;
+	for (int i=0; i<NB_SPAN; i++) {
+		int NbRow=5+(i*7)%11;
+		long long *T=Regular(NbRow, First);
+		Spans[i].RunNo=10+i/10; Spans[i].First=T[0]; Spans[i].Last=T[NbRow-1];
+		if (i%5==4) { Spans[i].CycNo=Spans[i-1].CycNo; Spans[i].SizeIdx=1; }	// 2nd part of the previous cycle
+		else Spans[i].CycNo=i%10;
+		const char* Hd=WriteHeader(Root, 1, Spans[i].RunNo, Spans[i].CycNo, Spans[i].SizeIdx, "idx", 4, T[0], T[NbRow-1], NULL);
+		AppendData(ConfigToDataName(Hd), 4, T, 0, NbRow, 0, 0);
+		First=T[NbRow-1]+(i%10==5 ? 100000 : 1);	// With a gap
+		free(T);
+	}
+	WriteHeader(Root, 1, 20, 0, 0, "idx", 4, 0, FIRST, NULL);	// No firstTimeStamp and no data: not indexed
+	for (int WithCatalog=0; WithCatalog<2; WithCatalog++) {
+		int Level=SimpleLog_FilterLevel(0);	// The header without data is expected
+		if (WithCatalog) CHECK(N2_UpdateCatalog(Root, 1, 0)>0);
+		tN2timeIndex *Index=N2_BuildTimeIndex(Root, 1, "idx");
+		SimpleLog_FilterLevel(Level);
+		CHECK(Index!=NULL);
+		if (Index==NULL) continue;
+		for (int i=0; i<NB_SPAN; i++)
+			for (long long d=-1500; d<=1500; d+=700) {
+				CheckFind(Index, Spans[i].First+d, Spans[i].First+d);
+				CheckFind(Index, Spans[i].First+d, Spans[i].First+d+3000);
+			}
+		CheckFind(Index, 0, LLONG_MAX);
+		CheckFind(Index, 0, 10);
+		N2_FreeTimeIndex(Index);
+	}
+	N2_RemoveCatalog(Root);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	N2_JoinAsOf() keeps every driver row, even with duplicate timestamps
+///////////////////////////////////////////////////////////////////////////////
+static void TestJoin(void) {
+	long long TD[]={FIRST+10, FIRST+20, FIRST+20, FIRST+30, 0}, TO[]={FIRST+5, FIRST+20, FIRST+25, 0};
+	const char* Hd=WriteHeader(Root, 1, 2, 1, 0, "drv", 3, TD[0], TD[3], NULL);
+	AppendData(ConfigToDataName(Hd), 3, TD, 0, 4, 0, 0);
+	tN2data Drive={0}, Other={0};
+	CHECK(N2_ReadFile(Hd, &Drive)==4);
+	Hd=WriteHeader(Root, 1, 2, 1, 0, "oth", 3, TO[0], TO[2], NULL);
+	AppendData(ConfigToDataName(Hd), 3, TO, 0, 3, 0, 0);
+	CHECK(N2_ReadFile(Hd, &Other)==3);
+	tN2data *In[2]={&Drive, &Other};
+
+	tN2data Dest={0};
+	CHECK(N2_JoinAsOf(&Dest, In, 2, -1, 0)==4);
+	CHECK(Dest.NbCol==5 and 0==strcmp(Dest.Columns[3].Name, "oth.ADC1"));
+	long long DriveRow[]={0, 1, 2, 3}, OtherRow[]={0, 1, 1, 2};
+	for (int i=0; i<4; i++) {
+		CHECK(Dest.TimeStamp[i]==TD[i]);
+		CHECK(N2_CELL(&Dest, i, 2, long long)==DriveRow[i]*100+2);
+		CHECK(N2_CELL(&Dest, i, 4, long long)==OtherRow[i]*100+2);
+	}
+	N2_ClearConfig(&Dest);
+
+	CHECK(N2_JoinAsOf(&Dest, In, 2, 0, 0)==4);	// Exact matches only
+	for (int i=0; i<4; i++) {
+		int Match=(TD[i]==FIRST+20);
+		CHECK(N2_CELL(&Dest, i, 2, long long)==DriveRow[i]*100+2);
+		CHECK(Match ? N2_CELL(&Dest, i, 4, long long)==1*100+2 : (unsigned long long)N2_CELL(&Dest, i, 4, long long)==N2_JOIN_MISSING);
+		CHECK(Match ? N2_CELL(&Dest, i, 3, double)==1*100+1 : isnan(N2_CELL(&Dest, i, 3, double)));
+	}
+	N2_ClearConfig(&Dest);
+
+	CHECK(N2_JoinAsOf(&Dest, In, 2, -1, 1)==5);	// Union of the distinct timestamps
+	long long TU[]={FIRST+5, FIRST+10, FIRST+20, FIRST+25, FIRST+30};
+	for (int i=0; i<5; i++) CHECK(Dest.TimeStamp[i]==TU[i]);
+	CHECK((unsigned long long)N2_CELL(&Dest, 0, 2, long long)==N2_JOIN_MISSING);
+	CHECK(N2_CELL(&Dest, 2, 2, long long)==2*100+2);	// Last of the duplicates
+	N2_ClearConfig(&Dest);
+	N2_ClearConfig(&Drive); N2_ClearConfig(&Other);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	ParseHeader() fills N2data like libconfig does
+///////////////////////////////////////////////////////////////////////////////
+static void TestParseHeader(void) {
+	char Path[PATH_MAX];
+	tN2data A={0}, B={0}, X={0};
+	strcpy(Path, WriteHeader(Root, 1, 3, 1, 0, "hgm", 7, FIRST, FIRST+99000, NULL));
+	CHECK(ParseHeader(Path, NULL, &X)==1);
+	N2_ClearConfig(&X);
+	CHECK(N2_ReadConfig(Path, &A, 1)==7);
+	WriteHeader(Root, 1, 3, 1, 0, "hgm", 7, FIRST, FIRST+99000, "extra = [1, 2];\n");	// Left to libconfig
+	CHECK(ParseHeader(Path, NULL, &X)==0);
+	N2_ClearConfig(&X);
+	CHECK(N2_ReadConfig(Path, &B, 1)==7);
+
+	CHECK(A.Name and B.Name and 0==strcmp(A.Name, B.Name));
+	CHECK(A.RunNo==B.RunNo and A.CycNo==B.CycNo and A.HdrVer==B.HdrVer);
+	CHECK(A.NbCol==B.NbCol and A.NbFileCol==B.NbFileCol);
+	CHECK(A.EOLidentifier==B.EOLidentifier and A.EOLidentifier==EOLV);
+	CHECK(A.FirstTimeStamp==B.FirstTimeStamp and A.LastTimeStamp==B.LastTimeStamp and A.LastWrite==B.LastWrite);
+	for (int c=0; c<A.NbCol and c<B.NbCol; c++) {
+		CHECK(0==strcmp(A.Columns[c].Name,        B.Columns[c].Name));
+		CHECK(0==strcmp(A.Columns[c].Description, B.Columns[c].Description));
+		CHECK(0==strcmp(A.Columns[c].DataType,    B.Columns[c].DataType));
+		CHECK(0==strcmp(A.Labels[c],              B.Labels[c]));
+	}
+	N2_ClearConfig(&A); N2_ClearConfig(&B);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// HIFN	N2_PollFollow() leaves an incomplete trailing record for the next call, and N2_FlushFollow() takes
+/// HIFN	a last record with a wrong EOL. Without firstTimeStamp, the relative times start at the 1st record
+///////////////////////////////////////////////////////////////////////////////
+static void TestFollow(void) {
+	const int NbCol=4, RecSize=(NbCol+1)*8;
+	long long *T=Regular(20, FIRST);
+	char Hd[PATH_MAX], Data[PATH_MAX];
+	strcpy(Hd, WriteHeader(Root, 1, 4, 1, 0, "hgm", NbCol, T[0], T[1], NULL));
+	strcpy(Data, ConfigToDataName(Hd));
+	tN2follow Follow;
+	CHECK(0==N2_OpenFollow(Hd, &Follow, NULL));
+	CHECK(0==N2_PollFollow(&Follow, 1));		// No data file yet
+	AppendData(Data, NbCol, T, 0, 5, 0, 7);
+	CHECK(5==N2_PollFollow(&Follow, 1));
+	CHECK(CheckRows(&Follow.N2data, T, 0, 5));
+	CHECK(0==N2_PollFollow(&Follow, 1));
+	CHECK(0==truncate(Data, 5*RecSize));		// The writer completes the record
+	AppendData(Data, NbCol, T, 5, 9, 0, 0);
+	CHECK(4==N2_PollFollow(&Follow, 1));
+	CHECK(CheckRows(&Follow.N2data, T, 0, 9));
+	CHECK(Follow.NbRowTotal==9);
+	N2_CloseFollow(&Follow);
+	
+	strcpy(Hd, WriteHeader(Root, 1, 4, 2, 0, "hgm", NbCol, 0, 0, NULL));	// No firstTimeStamp, and no data file yet
+	strcpy(Data, ConfigToDataName(Hd));
+	CHECK(0==N2_OpenFollow(Hd, &Follow, NULL));
+	CHECK(0==N2_PollFollow(&Follow, 1));
+	AppendData(Data, NbCol, T, 3, 8, 0, 0);
+	AppendData(Data, NbCol, T, 8, 9, 8, 0);		// Wrong EOL on the last record
+	CHECK(5==N2_PollFollow(&Follow, 1));
+	CHECK(Follow.N2data.FirstTimeStamp==T[3] and N2_CELL(&Follow.N2data, 4, 0, double)==NANO_TO_SEC(T[7]-T[3]));
+	CHECK(0==N2_PollFollow(&Follow, 1));		// Maybe not written yet
+	int Level=SimpleLog_FilterLevel(0);			// The wrong EOL is expected
+	CHECK(1==N2_FlushFollow(&Follow, 1));
+	SimpleLog_FilterLevel(Level);
+	CHECK(CheckRows(&Follow.N2data, T, 3, 6) and Follow.NbRowTotal==6);
+	CHECK(0==N2_FlushFollow(&Follow, 1));
+	N2_CloseFollow(&Follow);
+	free(T);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+static void RemoveTree(const char* Dir) {
+	DIR *D=opendir(Dir);
+	if (D==NULL) return;
+	struct dirent *E;
+	char Path[PATH_MAX+256];
+	while ((E=readdir(D))!=NULL)
+		if (strcmp(E->d_name, ".") and strcmp(E->d_name, "..")) {
+			sprintf(Path, "%s/%s", Dir, E->d_name);
+			if (unlink(Path)<0) RemoveTree(Path);
+		}
+	closedir(D);
+	rmdir(Dir);
+}
+
+int main(void) {
+	SimpleLog_Setup(NULL, NULL, 0, 0, 0, "\t");
+	SimpleLog_FilterLevel(SL_ERROR);
+	strcpy(Root, "/tmp/N2readData_testXXXXXX");
+	if (NULL==mkdtemp(Root)) { perror(Root); return 1; }
+
+	TestDecode();
+	TestMap();
+	TestStream();
+	TestReadRun();
+	TestCatalog();
+	TestWalk();
+	TestFind();
+	TestWatch();
+	TestRunTimeStamps();
+	TestAddData();
+	TestPrefetch();
+	TestBatch();
+	TestHeaderCache();
+	TestWindow();
+	TestTimeIndex();
+	TestJoin();
+	TestParseHeader();
+	TestFollow();
+
+	N2_ClearStuff();
+	RemoveTree(Root);
+	if (NbAlloc!=NbFree) { fprintf(stderr, "NbAlloc=%d, NbFree=%d\n", NbAlloc, NbFree); NbFail++; }
+	printf("%s: %d failure(s)\n", NbFail ? "FAILED" : "OK", NbFail);
+	return NbFail!=0;
+}
@@ -17,6 +17,7 @@ int main( int argc, char ** argv ){
 	if( argc != 5 ){
 		cerr << "Incorrect number of arguments. Instead use:\n";
 		cerr << "\t./counts_analysis [input run] [input cycle] [start time] [stop time]\n";
+		cerr << "\ttimes in s since the start of the cycle\n";
 		return -1;
 	}	
 	int input_run = atoi(argv[1]);
@@ -32,9 +33,10 @@ int main( int argc, char ** argv ){
 	////////////////////////////////////////////////////////////////////////
 	// Load Hgm file
 	std::string filename_hgm = format_EDM_filename(input_run,input_cycle,"hgm");
-	tN2data N2data_hgm = {0};
-	N2_ReadFile(filename_hgm.c_str(), &N2data_hgm);
-	if( !N2data_hgm.Data ){
+	tN2data N2data_hgm = {};
+	N2data_hgm.Columnar = 1;	// one contiguous array per column
+	// only the ADC channels, kept at the same indices, and only the rows within the window (s since the start of the cycle)
+	if( N2_ReadFileRelWindow(filename_hgm.c_str(), &N2data_hgm, "1,2,3,4,5,6,7", start_time, stop_time) < 0 || !N2data_hgm.Cols ){
 		cerr << "Could not open file " << filename_hgm << "\n";
 		exit(-1);
 	}
@@ -42,21 +44,23 @@ int main( int argc, char ** argv ){
 	////////////////////////////////////////////////////////////////////////
 	// Loop over data
 	uint64_t file_start_time_hgm 	= (long long)N2data_hgm.FirstTimeStamp;
-	if( N2data_hgm.Data && N2data_hgm.NbRow > 0 && N2data_hgm.ReservedSize > 0 ){
+	if( N2data_hgm.Cols && N2data_hgm.NbRow > 0 && N2data_hgm.ReservedSize > 0 ){
+		// one pointer per ADC channel, each streaming through its own column
+		const double * const * ADC = (const double * const *)N2data_hgm.Cols;
 		// for each event in the hgm:
-		for( int r=0; r<N2data_hgm.NbRow ; r++ ){
+		for( long long r=0; r<N2data_hgm.NbRow ; r++ ){
 
 			// get timestamp for event since start time:
 			uint64_t current_hgm_time = (((long long *)N2data_hgm.TimeStamp)[r]) - file_start_time_hgm;
 			double HgM_Time = current_hgm_time/1E9; // in s
 			// read ADC data
-			double ADC1 = ((double **)N2data_hgm.Data)[r][1];
-			double ADC2 = ((double **)N2data_hgm.Data)[r][2];
-			double ADC3 = ((double **)N2data_hgm.Data)[r][3];
-			double ADC4 = ((double **)N2data_hgm.Data)[r][4];
-			double ADC5 = ((double **)N2data_hgm.Data)[r][5];
-			double ADC6 = ((double **)N2data_hgm.Data)[r][6];
-			double ADC7 = ((double **)N2data_hgm.Data)[r][7];
+			double ADC1 = ADC[1][r];
+			double ADC2 = ADC[2][r];
+			double ADC3 = ADC[3][r];
+			double ADC4 = ADC[4][r];
+			double ADC5 = ADC[5][r];
+			double ADC6 = ADC[6][r];
+			double ADC7 = ADC[7][r];
 				
 			// do stuff here with data
 			cout << HgM_Time << " " << ADC1 << " " << ADC2 << " " << ADC3 << " " << ADC4 << " " << ADC5 << " " << ADC6 << " " << ADC7 << "\n";		